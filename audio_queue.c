@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+#include "pico/audio_i2s.h"  // pico-extras
+
+#include "audio_queue.h"
+#include "constants.h"
+#include "debug.h"
+
+volatile bool flush_pending = false;
+volatile uint64_t flush_requested_at = 0; // us, when the button was pressed
+bool latency_pending = false;
+bool first_buffer = true;
+
+void audio_request_flush() {
+    flush_requested_at = time_us_64();
+    flush_pending = true;
+}
+
+bool audio_flush_pending() {
+    return flush_pending;
+}
+
+uint audio_flush(struct audio_buffer_pool *ap) {
+    // Clear first: a request that arrives while we're flushing will be
+    // picked up on the next pass.
+    flush_pending = false;
+
+    // give_audio_buffer() puts buffers on the producer pool's "full" list and
+    // the I2S consumer only pulls from it when its DMA needs more data. So
+    // whatever is still in that list hasn't been heard yet and can go straight
+    // back on the free list. Only the buffer the DMA is playing remains.
+    uint count = 0;
+    struct audio_buffer *buffer;
+    while ((buffer = get_full_audio_buffer(ap, false)) != NULL) {
+        queue_free_audio_buffer(ap, buffer);
+        count++;
+    }
+    PF("flushed %d queued buffers\n", count);
+    latency_pending = true;
+    return count;
+}
+
+void audio_give(struct audio_buffer_pool *ap, struct audio_buffer *buffer) {
+    give_audio_buffer(ap, buffer);
+#ifndef NDEBUG
+    if (first_buffer) {
+        first_buffer = false;
+        // the timer starts counting during the SDK's runtime init, right
+        // after reset
+        PF("first audio buffer %dus after reset\n", (int)time_us_32());
+    }
+    if (latency_pending) {
+        latency_pending = false;
+        // The new buffer is next in line, so it is heard at most one buffer
+        // period (the one the DMA is busy with) after it was queued.
+        uint32_t queued_us = (uint32_t)(time_us_64() - flush_requested_at);
+        uint32_t buffer_us = (buffer->max_sample_count * 1000) / SAMPLE_RATE_MS;
+        PF("button-to-audio latency: queued after %dus, heard within %dus\n",
+           queued_us, queued_us + buffer_us);
+    }
+#endif
+}
@@ -0,0 +1,44 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Helpers around the producer pool so a change of audio source is heard
+// right away instead of after the queued buffers drain.
+
+#ifndef TG_AUDIO_QUEUE_H
+#define TG_AUDIO_QUEUE_H
+
+#include "pico/stdlib.h"
+#include "pico/audio_i2s.h"  // pico-extras
+
+// Called (usually from the button IRQ) when the mode, sample or tone changes.
+// The main loop checks audio_flush_pending() before each buffer.
+void audio_request_flush();
+bool audio_flush_pending();
+
+// Reclaims buffers that were given but not yet picked up by the I2S consumer.
+// Call from the main loop before rendering audio for the new source.
+// Returns the number of buffers reclaimed.
+uint audio_flush(struct audio_buffer_pool *ap);
+
+// Use this instead of give_audio_buffer(). It logs the button-to-audio
+// latency for the first buffer after a flush.
+void audio_give(struct audio_buffer_pool *ap, struct audio_buffer *buffer);
+
+#endif
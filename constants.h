@@ -1,3 +1,12 @@
 #define SAMPLE_RATE    16000
 #define SAMPLE_RATE_MS 16
 #define MAX_POT 4095 // from adc_read()
+#define SAMPLES_PER_BUFFER 256 // per audio buffer. 16ms at SAMPLE_RATE
+
+// Buffers in the audio pool. Whatever is rendered waits behind the others,
+// so MIDI builds keep fewer: see midi_uart.h.
+#if TONEGEN_MIDI
+#define AUDIO_BUFFER_COUNT 2
+#else
+#define AUDIO_BUFFER_COUNT 3
+#endif
@@ -0,0 +1,144 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+#include <math.h>
+
+#include "envelope.h"
+
+// Exponential stages get to within 2^-ENV_TAIL_BITS (about -60dB) of their
+// span by the end, so they aim that far past the end point.
+#define ENV_TAIL_BITS 10
+
+static int32_t _exp_coef(uint32_t samples) {
+    if (samples == 0) {
+        return 0;
+    }
+    // c^samples == 2^-ENV_TAIL_BITS
+    return (int32_t)(exp2f(-(float)ENV_TAIL_BITS / samples) * 2147483648.0f);
+}
+
+void env_set_times(env_params_t *p, uint32_t attack, uint32_t hold, uint32_t decay,
+                   int32_t sustain, uint32_t release, uint32_t gate) {
+    p->attack = attack;
+    p->hold = hold;
+    p->decay = decay;
+    p->sustain = sustain;
+    p->release = release;
+    p->gate = gate;
+    p->attack_step = attack ? ENV_ONE / attack : ENV_ONE;
+    p->decay_coef = _exp_coef(decay);
+    p->release_coef = _exp_coef(release);
+}
+
+static void _enter(env_t *env, const env_params_t *p, uint8_t stage) {
+    env->stage = stage;
+    switch (stage) {
+        case ENV_ATTACK:
+            env->stage_left = p->attack;
+            break;
+        case ENV_HOLD:
+            env->level = ENV_ONE;
+            env->stage_left = p->hold;
+            break;
+        case ENV_DECAY:
+            env->stage_left = p->decay;
+            env->target = p->sustain - ((ENV_ONE - p->sustain) >> ENV_TAIL_BITS);
+            break;
+        case ENV_SUSTAIN: {
+            env->level = p->sustain;
+            uint32_t used = p->attack + p->hold + p->decay;
+            env->stage_left = p->gate == 0 ? ENV_FOREVER
+                            : p->gate > used ? p->gate - used : 0;
+            break;
+        }
+        case ENV_RELEASE:
+            env->stage_left = p->release;
+            env->target = -(env->level >> ENV_TAIL_BITS);
+            break;
+        case ENV_IDLE:
+            env->level = 0;
+            env->stage_left = ENV_FOREVER;
+            break;
+    }
+}
+
+void env_trigger(env_t *env, const env_params_t *p) {
+    env->level = 0;
+    _enter(env, p, ENV_ATTACK);
+}
+
+void env_release(env_t *env, const env_params_t *p) {
+    if (env->stage != ENV_IDLE && env->stage != ENV_RELEASE) {
+        _enter(env, p, ENV_RELEASE);
+    }
+}
+
+void env_render(env_t *env, const env_params_t *p, uint16_t *out, uint n) {
+    uint i = 0;
+    while (i < n) {
+        uint end = i + MIN(n - i, env->stage_left);
+        if (env->stage_left != ENV_FOREVER) {
+            env->stage_left -= end - i;
+        }
+        int32_t level = env->level;
+
+        switch (env->stage) {
+            case ENV_ATTACK:
+                for (; i < end; i++) {
+                    level += p->attack_step;
+                    out[i] = level >> 15;
+                }
+                break;
+
+            case ENV_DECAY:
+            case ENV_RELEASE: {
+                int32_t target = env->target;
+                int32_t coef = env->stage == ENV_DECAY ? p->decay_coef : p->release_coef;
+                int32_t floor = env->stage == ENV_DECAY ? p->sustain : 0;
+                for (; i < end; i++) {
+                    level = target + (int32_t)(((int64_t)(level - target) * coef) >> 31);
+                    if (level < floor) {
+                        level = floor;
+                    }
+                    out[i] = level >> 15;
+                }
+                break;
+            }
+
+            default: // hold, sustain and idle are flat
+                for (; i < end; i++) {
+                    out[i] = level >> 15;
+                }
+                break;
+        }
+        env->level = level;
+
+        if (env->stage_left == 0) {
+            switch (env->stage) {
+                case ENV_ATTACK:  _enter(env, p, ENV_HOLD); break;
+                case ENV_HOLD:    _enter(env, p, ENV_DECAY); break;
+                case ENV_DECAY:   _enter(env, p, ENV_SUSTAIN); break;
+                case ENV_SUSTAIN: _enter(env, p, ENV_RELEASE); break;
+                case ENV_RELEASE: _enter(env, p, ENV_IDLE); break;
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Attack/hold/decay/sustain/release envelopes in fixed point.
+//
+// The attack is a linear ramp. Decay and release are exponential: a one-pole
+// multiply by a Q31 coefficient each sample. Each heads for a target a little
+// past where it should end, so the curve arrives exactly when the stage's
+// sample count runs out instead of creeping up on it forever.
+//
+// env_set_times() works out the coefficients. It uses float, so call it when
+// the times change (e.g. the pot moved), never per sample.
+
+#ifndef TG_ENVELOPE_H
+#define TG_ENVELOPE_H
+
+#include "pico/stdlib.h"
+
+#define ENV_ONE (1 << 30) // full level
+#define ENV_FOREVER UINT32_MAX // stage_left for stages that don't end by themselves
+
+#define ENV_IDLE 0
+#define ENV_ATTACK 1
+#define ENV_HOLD 2
+#define ENV_DECAY 3
+#define ENV_SUSTAIN 4
+#define ENV_RELEASE 5
+
+typedef struct {
+    // all times in samples
+    uint32_t attack;
+    uint32_t hold;    // at full level after the attack
+    uint32_t decay;   // down to sustain
+    int32_t sustain;  // level, 0 to ENV_ONE
+    uint32_t release; // down to nothing
+    uint32_t gate;    // onset to release. 0 holds the sustain until env_release()
+
+    // derived by env_set_times()
+    int32_t attack_step;
+    int32_t decay_coef;   // Q31
+    int32_t release_coef; // Q31
+} env_params_t;
+
+typedef struct {
+    uint8_t stage;
+    uint32_t stage_left; // samples
+    int32_t level;
+    int32_t target;      // for decay and release
+} env_t;
+
+void env_set_times(env_params_t *p, uint32_t attack, uint32_t hold, uint32_t decay,
+                   int32_t sustain, uint32_t release, uint32_t gate);
+
+void env_trigger(env_t *env, const env_params_t *p);
+void env_release(env_t *env, const env_params_t *p);
+
+// Nothing to hear until the next env_trigger()
+static inline bool env_silent(const env_t *env) {
+    return env->stage == ENV_IDLE || (env->stage == ENV_SUSTAIN && env->level == 0);
+}
+
+// Writes n samples of the envelope level as Q15 (0 to 32768) to out.
+void env_render(env_t *env, const env_params_t *p, uint16_t *out, uint n);
+
+#endif
@@ -0,0 +1,172 @@
+#!/usr/bin/env perl
+use strict;
+use warnings;
+use 5.010001;
+
+# Generates the lookup tables (tables.c and tables.h) at build time so the
+# firmware doesn't compute any of them at boot.
+#
+# usage: gen_tables.pl OUTPUT_DIR [A4_HZ]
+
+use FindBin;
+use List::Util qw(min);
+use POSIX qw(floor);
+
+my $out_dir = shift;
+die "supply an output directory" unless defined $out_dir && -d $out_dir;
+my $a4_hz = shift // 440;
+die "A4 should be in Hz" unless $a4_hz =~ /^\d+(\.\d+)?$/;
+
+my $PI = 4 * atan2(1, 1);
+
+# The sample rate and pot range come from the firmware's constants.h, so
+# the phase increments can't get out of step with it.
+my %constants;
+open(my $kf, '<', "$FindBin::Bin/constants.h") or die "constants.h: $!";
+while (<$kf>) {
+    $constants{$1} = $2 if /^#define\s+(\w+)\s+(\d+)\b/;
+}
+close $kf;
+my $SAMPLE_RATE = $constants{SAMPLE_RATE} // die "no SAMPLE_RATE in constants.h";
+my $MAX_POT = $constants{MAX_POT} // die "no MAX_POT in constants.h";
+
+# A full cycle would be 2^11 entries, we store a quarter of it.
+my $SINE_QUARTER_BITS = 9;
+my $SINE_QUARTER_LEN = 1 << $SINE_QUARTER_BITS;
+
+my (@h, @c);
+
+sub round {
+    my $v = shift;
+    return floor($v + 0.5);
+}
+
+sub emit_array {
+    my ($type, $name, $len, @values) = @_;
+    push @h, "extern const $type $name\[$len\];";
+    push @c, "const $type $name\[$len\] = {";
+    while (my @row = splice(@values, 0, 8)) {
+        push @c, join(',', @row) . ',';
+    }
+    push @c, "};", "";
+}
+
+# sin(0) to sin(pi/2) inclusive, see oscillator.h
+push @h, "#define SINE_QUARTER_BITS $SINE_QUARTER_BITS";
+emit_array('int16_t', 'sine_quarter_table', $SINE_QUARTER_LEN + 1,
+    map { round(32767 * sin($_ * ($PI / 2) / $SINE_QUARTER_LEN)) } 0 .. $SINE_QUARTER_LEN);
+
+# Band-limited square, sawtooth and triangle waves for oscillator.c, one
+# table per octave of phase increment ("mip-mapped"). The band for a delta is
+# the position of its top bit, and each band's table only has the harmonics
+# that stay under Nyquist for the fastest delta in it: 2^(30 - band).
+# Bands below WAVETABLE_MIN_BAND (under ~15Hz) share the lowest table.
+my $WAVETABLE_BITS = 11;
+my $WAVETABLE_LEN = 1 << $WAVETABLE_BITS;
+my $WAVETABLE_MIN_BAND = 21;
+my $WAVETABLE_BANDS = 31 - $WAVETABLE_MIN_BAND;
+my @shapes = (
+    # name, amplitude of harmonic n
+    [ 'SQUARE',   sub { my $n = shift; $n % 2 ? 1 / $n : 0 } ],
+    [ 'SAW',      sub { my $n = shift; ($n % 2 ? 1 : -1) / $n } ],
+    [ 'TRIANGLE', sub { my $n = shift; $n % 2 ? (($n - 1) / 2 % 2 ? -1 : 1) / ($n * $n) : 0 } ],
+);
+
+push @h, "", "#define WAVETABLE_BITS $WAVETABLE_BITS";
+push @h, "#define WAVETABLE_MIN_BAND $WAVETABLE_MIN_BAND";
+push @h, "#define WAVETABLE_BANDS $WAVETABLE_BANDS";
+my @wavetables;
+for my $s (0 .. $#shapes) {
+    my ($name, $amp) = @{$shapes[$s]};
+    push @h, "#define WAVETABLE_$name $s";
+
+    # Work from the top band down, adding the extra harmonics each time.
+    my @sum = (0) x ($WAVETABLE_LEN + 1);
+    my $harmonics = 0;
+    my @bands;
+    for (my $band = 30; $band >= $WAVETABLE_MIN_BAND; $band--) {
+        my $top = 1 << (30 - $band);
+        $top = $WAVETABLE_LEN / 2 - 1 if $top >= $WAVETABLE_LEN / 2;
+        for my $n ($harmonics + 1 .. $top) {
+            my $a = $amp->($n);
+            next unless $a;
+            for my $i (0 .. $WAVETABLE_LEN) {
+                $sum[$i] += $a * sin(2 * $PI * $n * $i / $WAVETABLE_LEN);
+            }
+        }
+        $harmonics = $top;
+        unshift @bands, [@sum];
+    }
+
+    # Scale every band by the same amount so the level doesn't jump between
+    # octaves. The lowest band has the most Gibbs overshoot.
+    my $peak = 0;
+    for my $t (@bands) {
+        for (@$t) { $peak = abs($_) if abs($_) > $peak }
+    }
+    push @wavetables, map { round(32767 * $_ / $peak) } @$_ for @bands;
+}
+push @h, "#define NUM_WAVETABLES " . scalar(@shapes);
+push @h, "// [shape][band][WAVETABLE_LEN + 1], flattened";
+emit_array('int16_t', 'wavetables', scalar(@wavetables), @wavetables);
+
+# Q15 gain for each whole dB of attenuation, 0dB (32768) down to about the
+# bottom of 16 bits. Index it with the attenuation: db_gain_table[20] is -20dB.
+my $DB_GAIN_STEPS = 97;
+push @h, "", "#define DB_GAIN_STEPS $DB_GAIN_STEPS";
+emit_array('uint16_t', 'db_gain_table', $DB_GAIN_STEPS,
+    map { round(32768 * 10 ** (-$_ / 20)) } 0 .. $DB_GAIN_STEPS - 1);
+
+# Phase increments for the variable oscillator, exponential in the pot from
+# 20Hz to 8kHz. Entry k is the pot reading k << POT_FREQ_SHIFT; read between
+# them with linear interpolation, which is within 0.2 cents of the curve.
+# The last entry is past MAX_POT, so it's held at POT_FREQ_MAX_HZ: the top of
+# the pot reads between the two and can't go over.
+my $POT_FREQ_SHIFT = 4;
+my $POT_FREQ_MIN_HZ = 20;
+my $POT_FREQ_MAX_HZ = 8000;
+my $pot_freq_steps = ($MAX_POT + 1) >> $POT_FREQ_SHIFT;
+push @h, "", "#define POT_FREQ_SHIFT $POT_FREQ_SHIFT";
+push @h, "#define POT_FREQ_MIN_HZ $POT_FREQ_MIN_HZ";
+push @h, "#define POT_FREQ_MAX_HZ $POT_FREQ_MAX_HZ";
+emit_array('uint32_t', 'pot_freq_table', $pot_freq_steps + 1,
+    map {
+        my $hz = $POT_FREQ_MIN_HZ
+            * ($POT_FREQ_MAX_HZ / $POT_FREQ_MIN_HZ)
+            ** (min($_ << $POT_FREQ_SHIFT, $MAX_POT) / $MAX_POT);
+        round($hz * 2 ** 32 / $SAMPLE_RATE)
+    } 0 .. $pot_freq_steps);
+
+# Equal tempered notes from E1 (a bass's low E) up to the last one under
+# Nyquist, tuned to A4.
+# NOTE_<name><octave> (# as S, e.g. NOTE_CS4) is the phase increment for
+# use in the pattern table; note_table[] has them all for picking by index.
+my $NOTE_FIRST_MIDI = 28; # E1
+my @note_names = qw(C CS D DS E F FS G GS A AS B);
+my @notes;
+push @h, "", "// Tuned to A4 = ${a4_hz}Hz";
+push @h, "#define NOTE_A4_HZ $a4_hz";
+push @h, "#define NOTE_FIRST_MIDI $NOTE_FIRST_MIDI";
+for (my $m = $NOTE_FIRST_MIDI; ; $m++) {
+    my $hz = $a4_hz * 2 ** (($m - 69) / 12);
+    last if $hz >= $SAMPLE_RATE / 2;
+    my $delta = round($hz * 2 ** 32 / $SAMPLE_RATE);
+    my $name = $note_names[$m % 12] . (int($m / 12) - 1);
+    push @h, "#define NOTE_$name $delta";
+    push @notes, $delta;
+}
+push @h, "#define NUM_NOTES " . scalar(@notes);
+emit_array('uint32_t', 'note_table', scalar(@notes), @notes);
+
+open(my $hf, '>', "$out_dir/tables.h") or die "tables.h: $!";
+print $hf "// Generated by gen_tables.pl. Do not edit.\n\n";
+print $hf "#ifndef TG_TABLES_H\n#define TG_TABLES_H\n\n#include <stdint.h>\n\n";
+print $hf "$_\n" for @h;
+print $hf "\n#endif\n";
+close $hf;
+
+open(my $cf, '>', "$out_dir/tables.c") or die "tables.c: $!";
+print $cf "// Generated by gen_tables.pl. Do not edit.\n\n";
+print $cf "#include \"tables.h\"\n\n";
+print $cf "$_\n" for @c;
+close $cf;
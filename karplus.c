@@ -0,0 +1,143 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+#include <math.h>
+
+#include "constants.h"
+#include "karplus.h"
+
+// The allpass is only accurate for delays of about 0.1 to 1.1 samples, so
+// the whole number part is picked to leave at least this much.
+#define KS_MIN_FRACTION 0.1f
+
+static int16_t pool[KS_MAX_STRINGS][KS_MAX_DELAY];
+
+void ks_init(ks_t *ks, uint8_t slot) {
+    if (slot >= KS_MAX_STRINGS) {
+        panic("ks_init: no slot %d\n", slot);
+    }
+    ks->line = pool[slot];
+    ks->len = 1;
+    ks->pos = 0;
+    ks->line[0] = 0;
+    ks->last = 0;
+    ks->ap_coef = 0;
+    ks->stretch = 16384;
+    ks->ap_x1 = 0;
+    ks->ap_y1 = 0;
+    ks->loss = 0;
+    ks->noise = NULL;
+    ks->quiet = 0;
+    ks->rest = 0;
+}
+
+void ks_pluck(ks_t *ks, uint32_t delta, uint32_t decay, uint16_t brightness, noise_t *noise) {
+    float period = 4294967296.0f / (float)delta;
+
+    // 60dB over decay samples is decay / period trips round the loop, each
+    // losing target. A 50/50 average loses cos(w/2) of the fundamental;
+    // if that's too much, take weights s and 1-s with a gain of
+    // sqrt(1 - 4s(1-s) sin^2(w/2)) instead.
+    float w = 2.0f * (float)M_PI / period;
+    float trips = MAX((float)decay, 1.0f) / period;
+    float target = exp2f(-3.0f * log2f(10.0f) / trips);
+    float s = 0.5f;
+    float loss = target / cosf(w / 2);
+    if (loss > 1.0f) {
+        float sn = sinf(w / 2);
+        float k = (1.0f - target * target) / (4.0f * sn * sn);
+        s = (1.0f - sqrtf(1.0f - 4.0f * k)) / 2.0f;
+        loss = 1.0f;
+    }
+    ks->stretch = (int32_t)(s * 32768.0f);
+    ks->loss = (int32_t)(loss * 32768.0f);
+
+    // the loop is len + s (the average) + the allpass's fraction long
+    float whole = floorf(period - s - KS_MIN_FRACTION);
+    whole = MAX(whole, 2.0f);
+    whole = MIN(whole, (float)KS_MAX_DELAY);
+    float frac = period - s - whole;
+    ks->len = (uint16_t)whole;
+    ks->ap_coef = (int16_t)((1.0f - frac) / (1.0f + frac) * 32768.0f);
+    ks->ap_x1 = 0;
+    ks->ap_y1 = 0;
+
+    // Half scale noise through a one-pole lowpass for the brightness, with
+    // the DC taken back out: a string doesn't pluck to an offset.
+    int32_t y = 0;
+    int32_t sum = 0;
+    for (uint i = 0; i < ks->len; i++) {
+        y += ((noise_white(noise) / 2 - y) * brightness) >> 15;
+        ks->line[i] = (int16_t)y;
+        sum += y;
+    }
+    int32_t dc = sum / ks->len;
+    for (uint i = 0; i < ks->len; i++) {
+        ks->line[i] = (int16_t)(ks->line[i] - dc);
+    }
+    ks->pos = 0;
+    ks->last = 0;
+    ks->noise = noise;
+    ks->quiet = 0;
+    ks->rest = 0;
+}
+
+void __not_in_flash_func(ks_block)(ks_t *ks, int16_t *out, uint n) {
+    int16_t *line = ks->line;
+    uint pos = ks->pos;
+    int32_t last = ks->last;
+    int32_t x1 = ks->ap_x1;
+    int32_t y1 = ks->ap_y1;
+    uint quiet = ks->quiet;
+    int32_t rest = ks->rest;
+    for (uint i = 0; i < n; i++) {
+        // Rounding the average and the loss the same way every time would
+        // leave a bias that builds up round the loop (a DC offset), and
+        // quiet notes would get stuck where the loss rounds away. Random
+        // rounding is right on average, so they decay all the way down.
+        uint32_t r = noise_next(ks->noise);
+        int32_t v = line[pos];
+        int32_t x = (v * (32768 - ks->stretch) + last * ks->stretch + (int32_t)(r & 0x7FFF)) >> 15;
+        x = (x * ks->loss + (int32_t)(r >> 17)) >> 15;
+        last = v;
+        // allpass: y[n] = c x[n] + x[n-1] - c y[n-1]
+        int32_t y = ((ks->ap_coef * (x - y1) + (1 << 14)) >> 15) + x1;
+        x1 = x;
+        y1 = y;
+        line[pos] = (int16_t)y;
+        out[i] = (int16_t)y;
+        if (++pos >= ks->len) {
+            pos = 0;
+        }
+        if ((uint32_t)(y - rest + KS_QUIET) <= 2 * KS_QUIET) {
+            quiet++;
+        } else {
+            quiet = 0;
+            rest = y;
+        }
+    }
+    ks->quiet = (uint16_t)MIN(quiet, ks->len);
+    ks->rest = (int16_t)rest;
+    ks->pos = (uint16_t)pos;
+    ks->last = (int16_t)last;
+    ks->ap_x1 = x1;
+    ks->ap_y1 = y1;
+}
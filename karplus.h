@@ -0,0 +1,89 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Karplus-Strong plucked strings.
+//
+// A string is a delay line one period long, filled with a burst of noise
+// when it's plucked. Every sample the oldest value is averaged with the one
+// before it and fed back in, so the high harmonics die away faster than the
+// low ones, like a real string.
+//
+// A plain average loses so much each trip that notes above a few hundred
+// hertz die in a fraction of a second, so the weights are moved off 50/50
+// as far as needed to hit the decay time ("stretching"). Below that a loss
+// factor per trip sets the decay.
+//
+// The filter adds a fraction of a sample to the loop and the line can only
+// be a whole number of samples long, which would leave high notes badly out
+// of tune. A first order allpass in the loop makes up the fraction.
+//
+// Delay lines come from a static pool with one slot per string, so nothing
+// is allocated at run time.
+
+#ifndef TG_KARPLUS_H
+#define TG_KARPLUS_H
+
+#include "pico/stdlib.h"
+
+#include "noise.h"
+
+#define KS_MAX_STRINGS 6 // one per tone voice
+#define KS_MAX_DELAY 1024 // samples per slot, down to ~16Hz
+
+#define KS_FULL_BRIGHTNESS 32768 // Q15
+
+// After a string has died away the random rounding in the loop keeps it
+// chattering by one either way. Without any loss (high notes, see
+// ks_pluck()) nothing pulls it back to 0 either, so it can sit at a small
+// DC offset. Moving no more than this is silent.
+#define KS_QUIET 2
+
+typedef struct {
+    int16_t *line;  // this string's slot in the pool
+    uint16_t len;   // whole samples of delay in use
+    uint16_t pos;
+    int16_t last;   // the value read before line[pos]
+    int16_t ap_coef; // allpass, Q15
+    int32_t ap_x1;
+    int32_t ap_y1;
+    int32_t stretch; // weight of the older sample in the average, Q15, up to 1/2
+    int32_t loss;   // gain per trip round the loop, Q15
+    noise_t *noise; // dither for the loss, see ks_block()
+    uint16_t quiet; // samples in a row within KS_QUIET of rest, up to len
+    int16_t rest;   // the first of them
+} ks_t;
+
+void ks_init(ks_t *ks, uint8_t slot);
+
+// Tunes the string to the phase increment delta (see HZ()) and plucks it.
+// It falls 60dB in decay samples. brightness (Q15) is how much of the noise
+// burst's top end is left in, KS_FULL_BRIGHTNESS for all of it. Uses float
+// and fills the whole line, so call it once per note.
+void ks_pluck(ks_t *ks, uint32_t delta, uint32_t decay, uint16_t brightness, noise_t *noise);
+
+void ks_block(ks_t *ks, int16_t *out, uint n);
+
+// A whole trip round the loop is quiet, so the string is too until the next
+// ks_pluck()
+static inline bool ks_silent(const ks_t *ks) {
+    return ks->quiet >= ks->len;
+}
+
+#endif
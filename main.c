@@ -25,11 +25,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "button.h"
 
+#include "audio_queue.h"
 #include "constants.h"
 #include "debug.h"
+#include "render.h"
 #include "sample_player.h"
 #include "tone_player.h"
 #include "flash_settings.h"
+#if TONEGEN_MIDI
+#include "midi_uart.h"
+#endif
 
 #define PIN_LED_TONE 16
 #define PIN_BUTTON_TONE 17
@@ -52,10 +57,12 @@ uint16_t last_pot_val = 0;
 #define MODE_TONE 1
 uint8_t mode = MODE_SAMPLE;
 
-#define SAMPLES_PER_BUFFER 256 // TODO: What should this be?
-
 struct audio_buffer_pool *ap;
 
+render_node_t *sample_node;
+render_node_t *tone_node;
+uint32_t master_gain = RENDER_UNITY_GAIN;
+
 
 struct audio_buffer_pool *init_audio() {
     // TODO: Update this
@@ -73,7 +80,7 @@ struct audio_buffer_pool *init_audio() {
     // NOTE: this calloc()'s
     struct audio_buffer_pool *producer_pool =
         audio_new_producer_pool(&producer_format,
-                                3,  // buffer count? what is this
+                                AUDIO_BUFFER_COUNT,
                                 SAMPLES_PER_BUFFER);  // TODO: correct size
     // bool __unused ok;
     const struct audio_format *output_format;
@@ -135,6 +142,10 @@ void on_button_change(button_t *button_p) {
             break;
     }
 
+    // Don't make the user sit through the old mode's queued audio
+    // (or the rest of a plucked note).
+    audio_request_flush();
+
     if (settings_alarm_id > 0) {
         if (!cancel_alarm(settings_alarm_id)) {
             P("****** FAILED to cancel alarm*****\n");
@@ -185,6 +196,15 @@ int main() {
     tone_init();
     set_tone_speed_from_pot();
 
+    render_init();
+    sample_node = render_add("sample", render_sample, NULL);
+#if TONEGEN_MIDI
+    midi_uart_init();
+    render_add("midi", render_midi, NULL);
+#endif
+    tone_node = render_add("tone", render_tone, NULL);
+    render_add("gain", render_gain, &master_gain);
+
     settings_t settings = flash_read_settings();
     set_tone_num(settings.tone_num);
     set_sample_num(settings.sample_num);
@@ -200,12 +220,16 @@ int main() {
     PF("PICO_FLASH_SIZE_BYTES=%d", PICO_FLASH_SIZE_BYTES);
 
     while (true) {
-        if (mode == MODE_SAMPLE) {
-            play_sample(ap);
-        } else {
+        if (audio_flush_pending()) {
+            render_flush(ap);
+            restart_tone();
+        }
+        sample_node->enabled = (mode == MODE_SAMPLE);
+        tone_node->enabled = (mode == MODE_TONE);
+        if (mode == MODE_TONE) {
             set_tone_speed_from_pot();
-            play_tone(ap);
         }
+        render_pull(ap);
     }
 
     return 0;
@@ -0,0 +1,87 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "midi.h"
+
+void midi_parser_init(midi_parser_t *parser) {
+    parser->running = 0;
+    parser->needed = 0;
+    parser->count = 0;
+    parser->sysex = false;
+}
+
+// Data bytes that follow a status byte
+static uint8_t _data_len(uint8_t status) {
+    switch (status & 0xF0) {
+        case MIDI_PROGRAM:
+        case MIDI_PRESSURE:
+            return 1;
+        case 0xF0:
+            // system common: song position has two, MTC quarter frame and
+            // song select have one, tune request none
+            return status == 0xF2 ? 2 : (status == 0xF1 || status == 0xF3) ? 1 : 0;
+        default:
+            return 2;
+    }
+}
+
+bool midi_parse(midi_parser_t *parser, uint8_t byte, midi_msg_t *msg) {
+    if (byte >= MIDI_REALTIME) {
+        return false; // clock etc. can turn up anywhere and change nothing
+    }
+
+    if (byte & 0x80) {
+        parser->sysex = (byte == MIDI_SYSEX);
+        parser->count = 0;
+        if (byte >= MIDI_SYSEX) {
+            // system messages end running status. The common ones' data
+            // still has to be counted past, so it isn't taken for notes.
+            parser->needed = _data_len(byte);
+            parser->running = (parser->needed && !parser->sysex) ? byte : 0;
+        } else {
+            parser->running = byte;
+            parser->needed = _data_len(byte);
+        }
+        return false;
+    }
+
+    if (parser->sysex || parser->running == 0) {
+        return false; // sysex payload, or data we came in halfway through
+    }
+
+    parser->data[parser->count++] = byte;
+    if (parser->count < parser->needed) {
+        return false;
+    }
+    parser->count = 0;
+
+    uint8_t status = parser->running;
+    if (status >= MIDI_SYSEX) {
+        parser->running = 0; // a system common message, nothing for us
+        return false;
+    }
+    msg->status = status;
+    msg->data1 = parser->data[0];
+    msg->data2 = parser->needed > 1 ? parser->data[1] : 0;
+    if (midi_type(msg) == MIDI_NOTE_ON && msg->data2 == 0) {
+        msg->status = MIDI_NOTE_OFF | (status & 0x0F);
+    }
+    return true;
+}
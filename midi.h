@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// A MIDI byte stream parser. It has no Pico dependencies, so it can be fed
+// recorded streams on a host.
+//
+// Handles running status, realtime bytes in the middle of a message, and
+// skips system exclusive. Note on with velocity 0 comes out as note off.
+// Messages on every channel are passed on.
+
+#ifndef TG_MIDI_H
+#define TG_MIDI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// status bytes, without the channel
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_POLY_PRESSURE 0xA0
+#define MIDI_CC 0xB0
+#define MIDI_PROGRAM 0xC0
+#define MIDI_PRESSURE 0xD0
+#define MIDI_PITCH_BEND 0xE0
+#define MIDI_SYSEX 0xF0
+#define MIDI_SYSEX_END 0xF7
+#define MIDI_REALTIME 0xF8 // and up
+
+#define MIDI_CC_MOD_WHEEL 1
+#define MIDI_CC_ALL_SOUND_OFF 120
+#define MIDI_CC_ALL_NOTES_OFF 123
+
+typedef struct {
+    uint8_t status; // including the channel in the low 4 bits
+    uint8_t data1;  // note, controller, program...
+    uint8_t data2;  // velocity, value... 0 for one byte messages
+} midi_msg_t;
+
+static inline uint8_t midi_type(const midi_msg_t *msg) {
+    return msg->status & 0xF0;
+}
+
+typedef struct {
+    uint8_t running; // status the next data bytes belong to, 0 for none
+    uint8_t needed;  // data bytes in a message with that status
+    uint8_t count;   // data bytes so far
+    uint8_t data[2];
+    bool sysex;
+} midi_parser_t;
+
+void midi_parser_init(midi_parser_t *parser);
+
+// Feed one byte. Returns true, with msg filled in, when it completes a
+// channel message.
+bool midi_parse(midi_parser_t *parser, uint8_t byte, midi_msg_t *msg);
+
+#endif
@@ -0,0 +1,116 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "midi.h"
+#include "midi_uart.h"
+#include "tone_player.h"
+
+#define MIDI_UART uart0
+#define MIDI_UART_IRQ UART0_IRQ
+#define MIDI_BAUD 31250
+
+#define BUFFER_US (SAMPLES_PER_BUFFER * 1000 / SAMPLE_RATE_MS)
+
+// One producer (the RX interrupt) and one consumer (render_midi()), each
+// only writing its own index, so no locking. Each entry is the byte with
+// the low 24 bits of time_us_32() above it.
+#define MIDI_QUEUE_LEN 64 // a power of 2. 20ms of bytes at full speed
+uint32_t queue[MIDI_QUEUE_LEN];
+volatile uint32_t queue_head = 0; // written by the interrupt
+volatile uint32_t queue_tail = 0; // written by render_midi()
+
+uint32_t midi_overflows = 0;
+uint32_t midi_max_latency_us = 0;
+
+midi_parser_t parser;
+
+void _on_midi_rx() {
+    while (uart_is_readable(MIDI_UART)) {
+        uint8_t byte = uart_getc(MIDI_UART);
+        uint32_t head = queue_head;
+        if (head - queue_tail >= MIDI_QUEUE_LEN) {
+            midi_overflows++;
+            continue;
+        }
+        queue[head & (MIDI_QUEUE_LEN - 1)] = byte | (time_us_32() << 8);
+        __dmb(); // the entry has to be there before the new head is
+        queue_head = head + 1;
+    }
+}
+
+void midi_uart_init() {
+    midi_parser_init(&parser);
+    uart_set_baudrate(MIDI_UART, MIDI_BAUD);
+    irq_set_exclusive_handler(MIDI_UART_IRQ, _on_midi_rx);
+    irq_set_enabled(MIDI_UART_IRQ, true);
+    uart_set_irq_enables(MIDI_UART, true, false);
+}
+
+void _apply(const midi_msg_t *msg, uint32_t received) {
+    switch (midi_type(msg)) {
+        case MIDI_NOTE_ON: {
+            tone_note_on(msg->data1, msg->data2);
+            // Rendered now, then played after up to AUDIO_BUFFER_COUNT - 1
+            // buffers queued ahead and the one the DAC is playing (a copy, so
+            // its buffer is already back in the pool).
+            uint32_t waited = (time_us_32() - received) & 0xFFFFFF;
+            uint32_t latency = waited + AUDIO_BUFFER_COUNT * BUFFER_US;
+            if (latency > midi_max_latency_us) {
+                midi_max_latency_us = latency;
+            }
+            break;
+        }
+        case MIDI_NOTE_OFF:
+            tone_note_off(msg->data1);
+            break;
+        case MIDI_CC:
+            if (msg->data1 == MIDI_CC_MOD_WHEEL) {
+                // stands in for the pot until the pot moves
+                set_tone_speed((uint32_t)msg->data2 * MAX_POT / 127);
+            } else if (msg->data1 == MIDI_CC_ALL_SOUND_OFF
+                       || msg->data1 == MIDI_CC_ALL_NOTES_OFF) {
+                tone_all_notes_off();
+            }
+            break;
+        case MIDI_PROGRAM:
+            set_tone_num(msg->data1);
+            break;
+    }
+}
+
+void render_midi(void *ctx, int32_t *mix, uint n) {
+    while (queue_tail != queue_head) {
+        uint32_t tail = queue_tail;
+        __dmb(); // don't read the entry before seeing the head move
+        uint32_t entry = queue[tail & (MIDI_QUEUE_LEN - 1)];
+        queue_tail = tail + 1;
+
+        midi_msg_t msg;
+        if (midi_parse(&parser, entry & 0xFF, &msg)) {
+            _apply(&msg, entry >> 8);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// MIDI in on UART0's RX pin (31250 baud, so the debug output on its TX pin
+// runs at that rate too when MIDI is built in).
+//
+// The RX interrupt only timestamps bytes into a queue. render_midi() drains
+// it at the start of each buffer and plays the notes, so notes never change
+// in the middle of a buffer. A note waits up to one buffer to be rendered,
+// then behind the AUDIO_BUFFER_COUNT - 1 buffers already queued for the
+// DAC and the one it is playing: 48ms at most with the two buffers MIDI
+// builds use.
+
+#ifndef TG_MIDI_UART_H
+#define TG_MIDI_UART_H
+
+#include "pico/stdlib.h"
+
+// Bytes dropped because the queue was full, and the longest time from a
+// note on arriving to it reaching the DAC (us, an upper bound: it counts
+// every queued buffer as full). render_pull() logs them every ~16s, and
+// starts the latency over.
+extern uint32_t midi_overflows;
+extern uint32_t midi_max_latency_us;
+
+void midi_uart_init();
+
+// A render node. It doesn't add anything to the mix; put it before the tone
+// node so notes start in the buffer they were received before.
+void render_midi(void *ctx, int32_t *mix, uint n);
+
+#endif
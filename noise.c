@@ -0,0 +1,76 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+
+#include "noise.h"
+
+void noise_init(noise_t *noise, uint32_t seed) {
+    noise->state = seed ? seed : 1; // xorshift gets stuck on 0
+    noise->counter = 0;
+    noise->sum = 0;
+    for (uint i = 0; i < NOISE_PINK_ROWS; i++) {
+        noise->rows[i] = noise_white(noise) >> NOISE_PINK_SHIFT;
+        noise->sum += noise->rows[i];
+    }
+}
+
+void noise_white_block(noise_t *noise, int16_t *out, uint n) {
+    for (uint i = 0; i < n; i++) {
+        out[i] = noise_white(noise);
+    }
+}
+
+void noise_pink_block(noise_t *noise, int16_t *out, uint n) {
+    for (uint i = 0; i < n; i++) {
+        // The trailing zeros of the counter pick the row: row 0 every
+        // other sample, row 1 every 4th, and so on. Once every
+        // 2^NOISE_PINK_ROWS samples no row is due.
+        uint32_t c = ++noise->counter & ((1u << NOISE_PINK_ROWS) - 1);
+        if (c) {
+            uint k = __builtin_ctz(c);
+            int16_t r = noise_white(noise) >> NOISE_PINK_SHIFT;
+            noise->sum += r - noise->rows[k];
+            noise->rows[k] = r;
+        }
+        out[i] = (int16_t)(noise->sum + (noise_white(noise) >> NOISE_PINK_SHIFT));
+    }
+}
+
+// Galois feedback masks for maximal length, from order MLS_MIN_ORDER up
+static const uint32_t mls_taps[] = { 0xE08, 0x1C80, 0x3802, 0x6000, 0xB400 };
+
+void mls_start(mls_t *mls, uint8_t order) {
+    if (order < MLS_MIN_ORDER || order > MLS_MAX_ORDER) {
+        panic("mls_start: no order %d\n", order);
+    }
+    mls->state = MLS_SEED;
+    mls->taps = mls_taps[order - MLS_MIN_ORDER];
+}
+
+void mls_block(mls_t *mls, int16_t level, int16_t *out, uint n) {
+    uint32_t state = mls->state;
+    for (uint i = 0; i < n; i++) {
+        uint32_t bit = state & 1;
+        out[i] = bit ? level : -level;
+        state = (state >> 1) ^ (-bit & mls->taps);
+    }
+    mls->state = state;
+}
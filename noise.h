@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Noise generators, a few integer ops per sample so they can also go under
+// other signals.
+//
+// White noise is the top 16 bits of a xorshift32 PRNG.
+//
+// Pink noise is Voss-McCartney: NOISE_PINK_ROWS white values, where row k is
+// redrawn every 2^(k+1) samples, plus a fresh white value each sample. Each
+// row only has energy below its own update rate, so each adds about an
+// octave's worth to the sum and together they fall at roughly -3dB/octave
+// from Nyquist down to a fraction of a hertz. Only one row changes per
+// sample, so the sum is kept running.
+
+#ifndef TG_NOISE_H
+#define TG_NOISE_H
+
+#include "pico/stdlib.h"
+
+// With the white value that's 16 terms of 12 bits each, which just fits in
+// 16 bits without clipping.
+#define NOISE_PINK_ROWS 15
+#define NOISE_PINK_SHIFT 4
+
+typedef struct {
+    uint32_t state;   // xorshift32, never 0
+    uint32_t counter; // pink: picks the row to redraw
+    int32_t sum;      // pink: of rows[]
+    int16_t rows[NOISE_PINK_ROWS];
+} noise_t;
+
+// The same seed always gives the same noise.
+void noise_init(noise_t *noise, uint32_t seed);
+
+static inline uint32_t noise_next(noise_t *noise) {
+    uint32_t x = noise->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    noise->state = x;
+    return x;
+}
+
+// Full scale, uniform
+static inline int16_t noise_white(noise_t *noise) {
+    return (int16_t)(noise_next(noise) >> 16);
+}
+
+// Write n samples to out.
+void noise_white_block(noise_t *noise, int16_t *out, uint n);
+void noise_pink_block(noise_t *noise, int16_t *out, uint n);
+
+// Maximum length sequences, for impulse responses. A Galois LFSR of order
+// MLS_MIN_ORDER to MLS_MAX_ORDER runs through every non-zero state, so the
+// sequence repeats every 2^order - 1 samples and is the same every time
+// from the same seed.
+#define MLS_MIN_ORDER 12
+#define MLS_MAX_ORDER 16
+#define MLS_SEED 1
+
+typedef struct {
+    uint32_t state;
+    uint32_t taps;
+} mls_t;
+
+// Starts the sequence over from MLS_SEED.
+void mls_start(mls_t *mls, uint8_t order);
+
+static inline uint32_t mls_period(uint8_t order) {
+    return (1u << order) - 1;
+}
+
+// Writes n samples of +level or -level to out.
+void mls_block(mls_t *mls, int16_t level, int16_t *out, uint n);
+
+#endif
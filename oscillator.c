@@ -0,0 +1,172 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+#include <math.h>
+#if PICO_ON_DEVICE
+#include "hardware/interp.h"
+#endif
+
+#include "constants.h"
+#include "oscillator.h"
+
+void osc_init() {
+#if PICO_ON_DEVICE
+    // lane 0: ACCUM0 is the phase. RESULT0 = ACCUM0 + BASE0 (delta), which
+    // a pop writes back to ACCUM0.
+    interp_config cfg = interp_default_config();
+    interp_config_set_add_raw(&cfg, true);
+    interp_set_config(interp0, 0, &cfg);
+
+    // lane 1: RESULT1 = ACCUM0 >> SINE_LOOKUP_SHIFT, ready for
+    // osc_sine_lookup()
+    cfg = interp_default_config();
+    interp_config_set_cross_input(&cfg, true);
+    interp_config_set_shift(&cfg, SINE_LOOKUP_SHIFT);
+    interp_config_set_mask(&cfg, 0, 31 - SINE_LOOKUP_SHIFT);
+    interp_set_config(interp0, 1, &cfg);
+    interp0->base[1] = 0;
+#endif
+}
+
+void __not_in_flash_func(osc_sine_mix_block)(osc_t *oscs, const uint16_t *gains, uint count, int16_t *out, uint n) {
+    for (uint i = 0; i < n; i++) {
+        int32_t sum = 0;
+        for (uint j = 0; j < count; j++) {
+            sum += osc_next_sine(&oscs[j]) * gains[j];
+        }
+        out[i] = (int16_t)(sum >> 15);
+    }
+}
+
+#if PICO_ON_DEVICE
+void __not_in_flash_func(osc_sine_block)(osc_t *osc, int16_t *out, uint n) {
+    interp0->accum[0] = osc->phase;
+    interp0->base[0] = osc->delta;
+    for (uint i = 0; i < n; i++) {
+        // reading POP1 gives lane 1's result for the current phase and
+        // steps the phase on to the next sample
+        out[i] = osc_sine_lookup(interp0->pop[1]);
+    }
+    osc->phase = interp0->accum[0];
+}
+
+void __not_in_flash_func(osc_table_block)(osc_t *osc, const int16_t *table, int16_t *out, uint n) {
+    interp0->accum[0] = osc->phase;
+    interp0->base[0] = osc->delta;
+    for (uint i = 0; i < n; i++) {
+        out[i] = osc_table_lookup(table, interp0->pop[1]);
+    }
+    osc->phase = interp0->accum[0];
+}
+#else
+// host builds (e.g. PICO_PLATFORM=host) have no interpolator
+void osc_sine_block(osc_t *osc, int16_t *out, uint n) {
+    for (uint i = 0; i < n; i++) {
+        out[i] = osc_next_sine(osc);
+    }
+}
+
+void osc_table_block(osc_t *osc, const int16_t *table, int16_t *out, uint n) {
+    for (uint i = 0; i < n; i++) {
+        out[i] = osc_table_lookup(table, osc->phase >> SINE_LOOKUP_SHIFT);
+        osc->phase += osc->delta;
+    }
+}
+#endif
+
+void __not_in_flash_func(osc_glide_block)(osc_t *osc, const int16_t *table, uint32_t target,
+                                          uint8_t shift, int16_t *out, uint n) {
+    uint32_t phase = osc->phase;
+    uint32_t delta = osc->delta;
+    for (uint i = 0; i < n; i++) {
+        uint32_t r = phase >> SINE_LOOKUP_SHIFT;
+        out[i] = table ? osc_table_lookup(table, r) : osc_sine_lookup(r);
+        phase += delta;
+        // deltas are at most about 2^31 (Nyquist), so the difference fits
+        delta += (int32_t)(target - delta) >> shift;
+    }
+    osc->phase = phase;
+    osc->delta = delta;
+}
+
+void __not_in_flash_func(osc_fm_block)(osc_t *carrier, osc_t *mod, const uint16_t *index,
+                                       int16_t *out, uint n) {
+    uint32_t phase = carrier->phase;
+    uint32_t mod_phase = mod->phase;
+    for (uint i = 0; i < n; i++) {
+        // fits in 32 bits, and wrapping when it's shifted up is whole cycles
+        uint32_t offset = (uint32_t)(osc_sine_at(mod_phase) * index[i]) << FM_INDEX_SHIFT;
+        out[i] = osc_sine_at(phase + offset);
+        phase += carrier->delta;
+        mod_phase += mod->delta;
+    }
+    carrier->phase = phase;
+    mod->phase = mod_phase;
+}
+
+void osc_sweep_start(osc_sweep_t *sweep, uint32_t from, uint32_t to, uint32_t samples) {
+    sweep->shift = (int8_t)__builtin_clz(from);
+    sweep->m = from << sweep->shift;
+    sweep->down = to < from;
+    // ratio^samples = to / from. rate is Q32, so a 10s sweep lands within
+    // ~6ppm of to; rounding keeps the per sample steps from adding up a bias.
+    float r = expm1f(logf((float)to / (float)from) / (float)samples);
+    sweep->rate = (uint32_t)(fabsf(r) * 4294967296.0f + 0.5f);
+}
+
+// m is kept in [2^31, 2^32). The carry out of the add (or the top bit
+// dropping on the way down) tells us when to renormalize.
+static inline uint32_t _sweep_step(osc_sweep_t *sweep) {
+    uint32_t m = sweep->m;
+    uint32_t d = (uint32_t)(((uint64_t)m * sweep->rate + (1u << 31)) >> 32);
+    if (sweep->down) {
+        m -= d;
+        if (!(m & 0x80000000u)) {
+            m <<= 1;
+            sweep->shift++;
+        }
+    } else {
+        uint32_t next = m + d;
+        if (next < m) {
+            if (sweep->shift == 0) {
+                next = UINT32_MAX; // past 16kHz, stop here
+            } else {
+                next = (next >> 1) | 0x80000000u;
+                sweep->shift--;
+            }
+        }
+        m = next;
+    }
+    sweep->m = m;
+    return m >> sweep->shift;
+}
+
+void __not_in_flash_func(osc_sweep_block)(osc_t *osc, osc_sweep_t *sweep, int16_t *out, uint n) {
+    uint32_t phase = osc->phase;
+    uint32_t delta = osc->delta;
+    for (uint i = 0; i < n; i++) {
+        out[i] = osc_sine_at(phase);
+        phase += delta;
+        delta = _sweep_step(sweep);
+    }
+    osc->phase = phase;
+    osc->delta = delta;
+}
@@ -0,0 +1,164 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Wavetable oscillators built on a 32 bit phase accumulator (DDS).
+//
+// The whole uint32_t range is one cycle, so the phase wraps for free and the
+// top SINE_WAVE_TABLE_BITS bits are the table index. At 16kHz one step of
+// delta is 16000 / 2^32 Hz, well under a millihertz.
+//
+// Only the first quarter of the sine is stored; the other three are folded
+// onto it. The bits below the index are used to linearly interpolate between
+// entries, which keeps the error well under the 16 bit noise floor.
+//
+// Square, sawtooth and triangle come from band-limited wavetables, one per
+// octave, so they don't alias. Those are full cycles (no symmetry to fold)
+// read with the same accumulator and interpolation.
+//
+// On the RP2040, osc_sine_block() has INTERP0 on core 0 do the accumulate and
+// the shift/mask, so it is reserved for that: don't use it from interrupt
+// handlers.
+
+#ifndef TG_OSCILLATOR_H
+#define TG_OSCILLATOR_H
+
+#include "pico/stdlib.h"
+
+#include "tables.h" // generated, see gen_tables.pl
+
+#define SINE_WAVE_TABLE_BITS (SINE_QUARTER_BITS + 2) // a full cycle, if we stored one
+#define SINE_WAVE_TABLE_LEN (1 << SINE_WAVE_TABLE_BITS)
+#define SINE_QUARTER_LEN (1 << SINE_QUARTER_BITS)
+#define SINE_FRAC_BITS 16
+
+// phase >> SINE_LOOKUP_SHIFT is what osc_sine_lookup() takes: the quadrant
+// (2 bits), the index into the quarter table, then the interpolation fraction.
+#define SINE_LOOKUP_SHIFT (32 - 2 - SINE_QUARTER_BITS - SINE_FRAC_BITS)
+
+// sine_quarter_table (in tables.h) holds sin(0) to sin(pi/2), including the
+// end point so we can interpolate past the last entry.
+
+typedef struct {
+    uint32_t phase;
+    uint32_t delta; // added to phase every sample. HZ() (tone_patterns.h) or note_table
+} osc_t;
+
+void osc_init();
+
+static inline int16_t osc_sine_lookup(uint32_t r) {
+    uint32_t quadrant = r >> (SINE_QUARTER_BITS + SINE_FRAC_BITS);
+    if (quadrant & 1) {
+        r = ~r; // 2nd and 4th quarters run back down the table
+    }
+    uint32_t i = (r >> SINE_FRAC_BITS) & (SINE_QUARTER_LEN - 1);
+    int32_t frac = r & ((1 << SINE_FRAC_BITS) - 1);
+    int32_t a = sine_quarter_table[i];
+    int32_t v = a + (((sine_quarter_table[i + 1] - a) * frac
+                      + (1 << (SINE_FRAC_BITS - 1))) >> SINE_FRAC_BITS);
+    return (int16_t)((quadrant & 2) ? -v : v);
+}
+
+// Full scale sine at phase (the whole uint32_t range is one cycle).
+static inline int16_t osc_sine_at(uint32_t phase) {
+    return osc_sine_lookup(phase >> SINE_LOOKUP_SHIFT);
+}
+
+static inline int16_t osc_next_sine(osc_t *osc) {
+    int16_t v = osc_sine_at(osc->phase);
+    osc->phase += osc->delta;
+    return v;
+}
+
+// Writes n samples of full scale sine to out and advances the phase.
+void osc_sine_block(osc_t *osc, int16_t *out, uint n);
+
+// Sums count sines in one pass, each scaled by its Q15 gain. The gains must
+// add up to 32768 or less: then the output can't clip, whatever the phases.
+void osc_sine_mix_block(osc_t *oscs, const uint16_t *gains, uint count, int16_t *out, uint n);
+
+#define WAVETABLE_LEN (1 << WAVETABLE_BITS)
+// Square edges can jump nearly full scale between entries, so interpolate
+// with 15 bits to keep the product in 32 bits.
+#define WAVETABLE_FRAC_BITS 15
+#define WAVETABLE_FRAC_SHIFT (32 - SINE_LOOKUP_SHIFT - WAVETABLE_BITS - WAVETABLE_FRAC_BITS)
+
+// The table for shape (WAVETABLE_SQUARE, ...) with only the harmonics that
+// fit under Nyquist at this phase increment. Pick it once per block.
+static inline const int16_t *osc_wavetable(uint8_t shape, uint32_t delta) {
+    int band = delta ? 31 - __builtin_clz(delta) : 0;
+    band = MAX(band, WAVETABLE_MIN_BAND) - WAVETABLE_MIN_BAND;
+    band = MIN(band, WAVETABLE_BANDS - 1);
+    return &wavetables[(shape * WAVETABLE_BANDS + band) * (WAVETABLE_LEN + 1)];
+}
+
+// r is phase >> SINE_LOOKUP_SHIFT, same as osc_sine_lookup()
+static inline int16_t osc_table_lookup(const int16_t *table, uint32_t r) {
+    uint32_t i = r >> (WAVETABLE_FRAC_BITS + WAVETABLE_FRAC_SHIFT);
+    int32_t frac = (r >> WAVETABLE_FRAC_SHIFT) & ((1 << WAVETABLE_FRAC_BITS) - 1);
+    int32_t a = table[i];
+    return (int16_t)(a + (((table[i + 1] - a) * frac
+                           + (1 << (WAVETABLE_FRAC_BITS - 1))) >> WAVETABLE_FRAC_BITS));
+}
+
+// Like osc_sine_block(), from a table given by osc_wavetable().
+void osc_table_block(osc_t *osc, const int16_t *table, int16_t *out, uint n);
+
+// Two operator FM (phase modulation, as most FM synths do it): the
+// modulator's sine is added to the carrier's phase, scaled per sample by
+// index, so an envelope can move it. Two table reads per sample and no
+// tables of its own.
+//
+// index is the peak phase deviation, FM_INDEX(radians). At an index of beta
+// the sidebands, mod->delta apart, fall off past about beta + 1 either side
+// of the carrier; anything past Nyquist folds back down.
+#define FM_INDEX_SHIFT 3
+#define FM_INDEX(beta) ((uint16_t)((beta) * (4294967296.0 / (32768 << FM_INDEX_SHIFT)) \
+                                   / 6.283185307179586 + 0.5)) // up to 25 radians
+void osc_fm_block(osc_t *carrier, osc_t *mod, const uint16_t *index, int16_t *out, uint n);
+
+// Like osc_sine_block() (table NULL) or osc_table_block(), moving
+// osc->delta a 2^-shift step of the way to target every sample: a one-pole
+// glide, so a new frequency slides in instead of stepping. It settles
+// within 2^shift phase increment steps (a fraction of a millihertz) below
+// target.
+void osc_glide_block(osc_t *osc, const int16_t *table, uint32_t target, uint8_t shift,
+                     int16_t *out, uint n);
+
+// Exponential (log) frequency sweep. Each sample the phase increment is
+// multiplied by a constant ratio, so every octave takes the same time.
+//
+// delta is kept as a normalized mantissa (top bit set) and a shift, so one
+// 32x32 multiply per sample does the ratio with full precision at both ends
+// of the sweep, and nothing drifts from rounding the delta.
+typedef struct {
+    uint32_t m;     // delta << shift
+    int8_t shift;
+    bool down;
+    uint32_t rate;  // |ratio - 1|, Q32
+} osc_sweep_t;
+
+// Sets up a sweep from one phase increment to another over the given number
+// of samples. Uses float math, so call it once per sweep.
+void osc_sweep_start(osc_sweep_t *sweep, uint32_t from, uint32_t to, uint32_t samples);
+
+// Like osc_sine_block(), stepping osc->delta along the sweep every sample.
+void osc_sweep_block(osc_t *osc, osc_sweep_t *sweep, int16_t *out, uint n);
+
+#endif
@@ -0,0 +1,159 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+#include "pico/audio_i2s.h"  // pico-extras
+#include "hardware/structs/systick.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_queue.h"
+#include "constants.h"
+#include "debug.h"
+#include "render.h"
+#if TONEGEN_MIDI
+#include "midi_uart.h"
+#endif
+
+// Print per-node cycle counts this often (in buffers). ~16s.
+#define STATS_INTERVAL 1000
+
+render_node_t nodes[RENDER_MAX_NODES];
+uint8_t num_nodes = 0;
+
+static int32_t bus[SAMPLES_PER_BUFFER];
+uint32_t buffers_rendered = 0;
+
+// Index of the first sample of the buffer being rendered, counted from boot
+// in samples that actually went out to the DAC.
+uint64_t samples_rendered = 0;
+
+// SysTick is a 24 bit down counter running at the CPU clock. That wraps
+// every ~134ms at 125MHz, which is plenty for timing one buffer.
+#define SYSTICK_MASK 0x00FFFFFF
+
+static inline uint32_t _cycles_since(uint32_t start) {
+    return (start - systick_hw->cvr) & SYSTICK_MASK;
+}
+
+#if TONEGEN_MIDI
+static void _print_midi_stats() {
+    PF("midi %dus max, %d lost\n", midi_max_latency_us, midi_overflows);
+    midi_max_latency_us = 0;
+}
+#endif
+
+void render_init() {
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // enable, processor clock, no interrupt
+}
+
+render_node_t *render_add(const char *name, render_fn_t render, void *ctx) {
+    if (num_nodes >= RENDER_MAX_NODES) {
+        panic("render_add: too many nodes\n");
+    }
+    render_node_t *node = &nodes[num_nodes++];
+    node->name = name;
+    node->render = render;
+    node->ctx = ctx;
+    node->enabled = true;
+    node->cycles = 0;
+    node->max_cycles = 0;
+    return node;
+}
+
+void render_gain(void *ctx, int32_t *mix, uint n) {
+    uint32_t gain = *(uint32_t *)ctx;
+    if (gain == RENDER_UNITY_GAIN) {
+        return;
+    }
+    for (uint i = 0; i < n; i++) {
+        mix[i] = (int32_t)(((int64_t)mix[i] * gain) >> 15);
+    }
+}
+
+void render_pull(struct audio_buffer_pool *ap) {
+    struct audio_buffer *buffer = take_audio_buffer(ap, true);
+    int16_t *samples = (int16_t *)buffer->buffer->bytes;
+    uint n = buffer->max_sample_count;
+
+    memset(bus, 0, n * sizeof(bus[0]));
+    for (uint8_t i = 0; i < num_nodes; i++) {
+        render_node_t *node = &nodes[i];
+        if (!node->enabled) {
+            continue;
+        }
+        uint32_t start = systick_hw->cvr;
+        node->render(node->ctx, bus, n);
+        node->cycles = _cycles_since(start);
+        if (node->cycles > node->max_cycles) {
+            node->max_cycles = node->cycles;
+        }
+    }
+
+    // mixer: saturate the bus down to the output format
+    for (uint i = 0; i < n; i++) {
+        int32_t v = bus[i];
+        if (v > INT16_MAX) {
+            v = INT16_MAX;
+        } else if (v < INT16_MIN) {
+            v = INT16_MIN;
+        }
+        samples[i] = (int16_t)v;
+    }
+    buffer->sample_count = n;
+    audio_give(ap, buffer);
+    samples_rendered += n;
+
+    if (++buffers_rendered % STATS_INTERVAL == 0) {
+#if TONEGEN_MIDI
+        // The UART runs at 31250 baud, so the full stats would block for
+        // longer than the two buffers queued. One line that fits the 32
+        // byte TX FIFO doesn't block.
+        _print_midi_stats();
+#else
+        render_print_stats();
+#endif
+    }
+}
+
+void render_flush(struct audio_buffer_pool *ap) {
+    // those samples were counted but will never be played
+    samples_rendered -= (uint64_t)audio_flush(ap) * SAMPLES_PER_BUFFER;
+}
+
+void render_mark(const char *what, uint offset) {
+    // Not PF(): markers are for measurements, so they're wanted in release
+    // builds too. Keep them to a few a second; the UART write blocks.
+    printf("mark %s @%llu\n", what, (unsigned long long)(samples_rendered + offset));
+}
+
+void render_print_stats() {
+    for (uint8_t i = 0; i < num_nodes; i++) {
+        PF("render %s: %d cycles/buffer (max %d)%s\n", nodes[i].name,
+           nodes[i].cycles, nodes[i].max_cycles,
+           nodes[i].enabled ? "" : " [off]");
+        nodes[i].max_cycles = 0;
+    }
+#if TONEGEN_MIDI
+    _print_midi_stats();
+#endif
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// A tiny render graph. Every buffer, each enabled node runs in the order it
+// was added: voices add their output into a shared 32 bit mix bus, later
+// nodes (gain, ...) process what's on the bus, and the result is saturated
+// down to 16 bits in the audio buffer. main() pulls one buffer at a time
+// with render_pull(), so nothing else needs to touch the buffer pool.
+
+#ifndef TG_RENDER_H
+#define TG_RENDER_H
+
+#include "pico/stdlib.h"
+#include "pico/audio_i2s.h"  // pico-extras
+
+#define RENDER_MAX_NODES 8
+
+#define RENDER_UNITY_GAIN 32768 // Q15
+
+// mix has n samples. Voices should add to it, not overwrite it.
+typedef void (*render_fn_t)(void *ctx, int32_t *mix, uint n);
+
+typedef struct {
+    const char *name;
+    render_fn_t render;
+    void *ctx;
+    bool enabled;
+    // CPU cycles spent in render(), measured with SysTick
+    uint32_t cycles;     // last buffer
+    uint32_t max_cycles; // since the last render_print_stats()
+} render_node_t;
+
+void render_init();
+render_node_t *render_add(const char *name, render_fn_t render, void *ctx);
+
+// Take one buffer, run every enabled node and give the buffer back.
+void render_pull(struct audio_buffer_pool *ap);
+
+// Use this instead of audio_flush() so render_mark() stays in step with
+// what is actually played.
+void render_flush(struct audio_buffer_pool *ap);
+
+// For nodes: logs "mark <what> @<sample>" over the UART, where <sample> is the
+// output sample index (since boot) of mix[offset] in the buffer being
+// rendered. Lines a capture up with the stimulus to the sample, e.g. the
+// start of each sweep.
+void render_mark(const char *what, uint offset);
+
+// A node that scales the mix bus. ctx points to a uint32_t Q15 gain.
+void render_gain(void *ctx, int32_t *mix, uint n);
+
+void render_print_stats();
+
+#endif
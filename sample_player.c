@@ -106,17 +106,13 @@ uint32_t recording_num_samples[NUM_RECORDINGS] = {
 };
 uint32_t sample_i = 0;
 
-void play_sample(struct audio_buffer_pool *ap) {
-    struct audio_buffer *buffer = take_audio_buffer(ap, true);
-    int16_t *samples = (int16_t *)buffer->buffer->bytes;
-    for (uint i = 0; i < buffer->max_sample_count; i++) {
-        samples[i] = recordings[recording_i][sample_i++];
+void render_sample(void *ctx, int32_t *mix, uint n) {
+    for (uint i = 0; i < n; i++) {
+        mix[i] += recordings[recording_i][sample_i++];
         if (sample_i >= recording_num_samples[recording_i]) {
             sample_i = 0;
         }
     }
-    buffer->sample_count = buffer->max_sample_count;
-    give_audio_buffer(ap, buffer);
 }
 
 void next_sample() {
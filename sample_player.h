@@ -18,7 +18,8 @@ along with tonegen-v4; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
-void play_sample(struct audio_buffer_pool *ap);
+// render_fn_t for the render graph (see render.h)
+void render_sample(void *ctx, int32_t *mix, uint n);
 void next_sample();
 void set_sample_num(uint8_t i);
 uint8_t get_sample_num();
@@ -0,0 +1,133 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "render.h"
+#include "tone_player.h"
+
+int host_failures = 0;
+
+static uint32_t unity_gain = RENDER_UNITY_GAIN;
+static int16_t *render_out;
+
+void host_audio_out(const int16_t *samples, uint n) {
+    memcpy(render_out, samples, n * sizeof(samples[0]));
+    render_out += n;
+}
+
+static void _start_graph() {
+    static bool started = false;
+    if (!started) {
+        started = true; // the graph can't be taken apart again
+        render_init();
+        render_add("tone", render_tone, NULL);
+        render_add("gain", render_gain, &unity_gain);
+    }
+}
+
+void host_boot(uint8_t tone) {
+    _start_graph();
+    tone_init();
+    set_tone_num(tone);
+    restart_tone();
+}
+
+void host_play(uint8_t tone, uint16_t pot) {
+    _start_graph();
+    tone_init();
+    set_tone_speed(pot);
+    set_tone_num(tone);
+    restart_tone();
+}
+
+void host_render(int16_t *out, size_t n) {
+    if (n % SAMPLES_PER_BUFFER) {
+        panic("host_render: %zu isn't whole buffers\n", n);
+    }
+    render_out = out;
+    for (size_t i = 0; i < n; i += SAMPLES_PER_BUFFER) {
+        render_pull(NULL);
+    }
+}
+
+// Fits a * sin + b * cos at w (radians per sample), plus DC if with_dc.
+// Subtracts the fit from r and returns its RMS.
+static double _fit(double *r, size_t n, double w, bool with_dc) {
+    // normal equations for (sin, cos, 1)
+    double ss = 0, sc = 0, cc = 0, s1 = 0, c1 = 0, xs = 0, xc = 0, x1 = 0;
+    for (size_t i = 0; i < n; i++) {
+        double s = sin(w * i), c = cos(w * i);
+        ss += s * s; sc += s * c; cc += c * c; s1 += s; c1 += c;
+        xs += r[i] * s; xc += r[i] * c; x1 += r[i];
+    }
+    double m[3][4] = {
+        { ss, sc, s1, xs },
+        { sc, cc, c1, xc },
+        { s1, c1, (double)n, x1 },
+    };
+    int dim = with_dc ? 3 : 2;
+    for (int i = 0; i < dim; i++) { // Gauss-Jordan, it's well conditioned
+        for (int j = 0; j < dim; j++) {
+            if (j != i) {
+                double f = m[j][i] / m[i][i];
+                for (int k = 0; k < 4; k++) {
+                    m[j][k] -= f * m[i][k];
+                }
+            }
+        }
+    }
+    double a = m[0][3] / m[0][0], b = m[1][3] / m[1][1], dc = with_dc ? m[2][3] / m[2][2] : 0;
+    for (size_t i = 0; i < n; i++) {
+        r[i] -= a * sin(w * i) + b * cos(w * i) + dc;
+    }
+    return sqrt((a * a + b * b) / 2);
+}
+
+double host_fit_sine(const int16_t *x, size_t n, double freq,
+                     double *residual_rms, double *thd_rms) {
+    double *r = malloc(n * sizeof(double));
+    for (size_t i = 0; i < n; i++) {
+        r[i] = x[i];
+    }
+    double w = 2 * M_PI * freq / SAMPLE_RATE;
+    double rms = _fit(r, n, w, true);
+    if (residual_rms) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += r[i] * r[i];
+        }
+        *residual_rms = sqrt(sum / n);
+    }
+    if (thd_rms) {
+        double sum = 0;
+        for (int k = 2; k <= 10 && k * freq < SAMPLE_RATE / 2; k++) {
+            double h = _fit(r, n, k * w, false);
+            sum += h * h;
+        }
+        *thd_rms = sqrt(sum);
+    }
+    free(r);
+    return rms;
+}
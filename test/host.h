@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Helpers for the host tests: play a tone pattern through the real render
+// graph and measure what comes out.
+
+#ifndef TG_TEST_HOST_H
+#define TG_TEST_HOST_H
+
+#include "pico/stdlib.h"
+#include <math.h>
+#include <stdio.h>
+
+// Counts a failure and prints it, then carries on so every result shows
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        host_failures++; \
+    } \
+} while (0)
+
+extern int host_failures;
+
+// Starts tone pattern tone from the beginning with the pot at pot
+void host_play(uint8_t tone, uint16_t pot);
+
+// Starts tone pattern tone the way main() does at power on with the pot
+// near 0: set_tone_speed() is never called. Only meaningful as the first
+// thing a test plays.
+void host_boot(uint8_t tone);
+
+// Renders n samples (a multiple of SAMPLES_PER_BUFFER) to out, the way
+// main() does: the tone node, then unity gain, then the mixer.
+void host_render(int16_t *out, size_t n);
+
+// Least squares fit of a sine at freq (Hz) plus DC. Returns the fitted
+// sine's RMS, and the RMS of what's left (THD+N) in residual_rms if it
+// isn't NULL. With thd_rms, also the RMS of harmonics 2 to 10 in the
+// residual.
+double host_fit_sine(const int16_t *x, size_t n, double freq,
+                     double *residual_rms, double *thd_rms);
+
+static inline double host_db(double ratio) {
+    return 20 * log10(ratio);
+}
+
+#endif
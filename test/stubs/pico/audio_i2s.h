@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// The producer pool side of pico-extras' audio API, for host tests. There
+// is one buffer, and every buffer given goes to host_audio_out().
+
+#ifndef TG_TEST_PICO_AUDIO_I2S_H
+#define TG_TEST_PICO_AUDIO_I2S_H
+
+#include "pico/stdlib.h"
+
+typedef struct mem_buffer {
+    uint8_t *bytes;
+    uint32_t size;
+} mem_buffer_t;
+
+typedef struct audio_buffer {
+    mem_buffer_t *buffer;
+    uint32_t sample_count;
+    uint32_t max_sample_count;
+} audio_buffer_t;
+
+typedef struct audio_buffer_pool {
+    int unused;
+} audio_buffer_pool_t;
+
+audio_buffer_t *take_audio_buffer(audio_buffer_pool_t *ap, bool block);
+void give_audio_buffer(audio_buffer_pool_t *ap, audio_buffer_t *buffer);
+audio_buffer_t *get_full_audio_buffer(audio_buffer_pool_t *ap, bool block);
+void queue_free_audio_buffer(audio_buffer_pool_t *ap, audio_buffer_t *buffer);
+
+// Defined by the test, see host.c
+void host_audio_out(const int16_t *samples, uint n);
+
+#endif
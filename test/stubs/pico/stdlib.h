@@ -0,0 +1,48 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Just enough of the Pico SDK for the DSP code to build on a host, see
+// test/CMakeLists.txt. Not used by the firmware.
+
+#ifndef TG_TEST_PICO_STDLIB_H
+#define TG_TEST_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h> // uint
+
+#define PICO_ON_DEVICE 0
+
+#define __not_in_flash_func(f) f
+
+#define MIN(a, b) ((b) > (a) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+static inline void __dmb(void) {}
+
+// The clock moves on SAMPLES_PER_BUFFER worth every time a buffer is given
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+
+void panic(const char *fmt, ...);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "pico/audio_i2s.h"
+#include "hardware/structs/systick.h"
+
+#include "constants.h"
+
+static systick_hw_t systick;
+systick_hw_t *systick_hw = &systick;
+
+static uint64_t now_us = 0;
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+void panic(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+static int16_t samples[SAMPLES_PER_BUFFER];
+static mem_buffer_t mem = { (uint8_t *)samples, sizeof(samples) };
+static audio_buffer_t buffer = { &mem, 0, SAMPLES_PER_BUFFER };
+
+audio_buffer_t *take_audio_buffer(audio_buffer_pool_t *ap, bool block) {
+    return &buffer;
+}
+
+void give_audio_buffer(audio_buffer_pool_t *ap, audio_buffer_t *b) {
+    host_audio_out((const int16_t *)b->buffer->bytes, b->sample_count);
+    now_us += (uint64_t)b->sample_count * 1000 / SAMPLE_RATE_MS;
+}
+
+// nothing is ever queued
+audio_buffer_t *get_full_audio_buffer(audio_buffer_pool_t *ap, bool block) {
+    return NULL;
+}
+
+void queue_free_audio_buffer(audio_buffer_pool_t *ap, audio_buffer_t *b) {
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+
+// Turning the pot while a plucked note decays. The note has to carry on
+// without a click: its times were set when it started.
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "tone_patterns.h"
+#include "tone_player.h"
+
+#define BUFFERS 20 // short of the next note at pot MAX_POT / 10
+#define MOVE_AT 8  // buffers in, the decay is about a quarter done
+#define CYCLE 62  // samples, a little over one cycle of C4
+static int16_t x[BUFFERS * SAMPLES_PER_BUFFER];
+
+// C4 plucked (pattern 1) with a short decay, then the pot turned right up
+// for the rest, and the other way
+static void _check_move(uint16_t from, uint16_t to) {
+    host_play(1, from);
+    host_render(x, MOVE_AT * SAMPLES_PER_BUFFER);
+    set_tone_speed(to);
+    host_render(x + MOVE_AT * SAMPLES_PER_BUFFER, (BUFFERS - MOVE_AT) * SAMPLES_PER_BUFFER);
+
+    // The peak of each cycle against the one before. A decay falls by much
+    // less than half a cycle even at its fastest; a level that snaps to the
+    // sustain drops out all at once. Quieter than -40dB doesn't count.
+    int peak = 0;
+    for (int i = 0; i < BUFFERS * SAMPLES_PER_BUFFER; i++) {
+        peak = MAX(peak, abs(x[i]));
+    }
+    int prev = 0, worst_at = 0;
+    double worst = 1;
+    for (int i = MS(PLUCK_TIME); i + CYCLE <= BUFFERS * SAMPLES_PER_BUFFER; i += CYCLE) {
+        int p = 0;
+        for (int j = i; j < i + CYCLE; j++) {
+            p = MAX(p, abs(x[j]));
+        }
+        if (prev > peak / 100 && (double)p / prev < worst) {
+            worst = (double)p / prev;
+            worst_at = i;
+        }
+        prev = p;
+    }
+    printf("pot %d to %d: fastest fall %.3f a cycle, at %d\n", from, to, worst, worst_at);
+    CHECK(worst > 0.5, "pot %d to %d: fell to %.3f in a cycle at sample %d, the note clicks",
+          from, to, worst, worst_at);
+}
+
+int main() {
+    _check_move(MAX_POT / 10, MAX_POT);
+    _check_move(MAX_POT, MAX_POT / 10);
+    return host_failures ? 1 : 0;
+}
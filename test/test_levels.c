@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// RMS of the calibrated reference tones against their nominal dBFS. A full
+// scale sine (peak 32767) is 0dBFS.
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "tone_patterns.h"
+
+#define N (38 * 1280) // 3s of whole buffers, and whole cycles of 100Hz and 1kHz
+#define MAX_ERROR_DB 0.01
+
+static int16_t x[N];
+
+int main() {
+    int checked = 0;
+    for (uint8_t t = 0; t < num_tone_patterns; t++) {
+        const staircase_t *st = tone_patterns[t].stairs;
+        if (st == NULL || st->from != st->to) {
+            continue; // only the reference tones hold one level
+        }
+        host_play(t, 0);
+        host_render(x, N);
+        double sum = 0;
+        for (size_t i = 0; i < N; i++) {
+            sum += (double)x[i] * x[i];
+        }
+        double dbfs = host_db(sqrt(sum / N) / (32767 / sqrt(2)));
+        double error = dbfs + st->from;
+        double freq = tone_patterns[t].notes[0] * (double)SAMPLE_RATE / 4294967296.0;
+        printf("pattern %d, %.0fHz at %ddBFS: %.4fdBFS (%+.4fdB)\n",
+               t, freq, -(int)st->from, dbfs, error);
+        CHECK(fabs(error) < MAX_ERROR_DB, "%+.4fdB off", error);
+        checked++;
+    }
+    CHECK(checked > 0, "no reference tones");
+    return host_failures ? 1 : 0;
+}
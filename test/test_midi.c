@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// The MIDI parser against recorded byte streams, then MIDI notes through
+// the tone player.
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "midi.h"
+#include "tone_patterns.h"
+#include "tone_player.h"
+
+typedef struct {
+    const char *name;
+    uint8_t bytes[16];
+    uint8_t num_bytes;
+    midi_msg_t want[4];
+    uint8_t num_want;
+} stream_t;
+
+static const stream_t streams[] = {
+    { "running status, note on velocity 0 is note off",
+      { 0x90, 60, 100, 62, 100, 60, 0, 62, 0 }, 9,
+      { { 0x90, 60, 100 }, { 0x90, 62, 100 }, { 0x80, 60, 0 }, { 0x80, 62, 0 } }, 4 },
+    { "realtime in the middle of messages",
+      { 0x90, 0xF8, 60, 0xFE, 100, 0xFA, 64, 90 }, 8,
+      { { 0x90, 60, 100 }, { 0x90, 64, 90 } }, 2 },
+    { "sysex is skipped",
+      { 0x90, 60, 1, 0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7, 0x80, 60, 0 }, 12,
+      { { 0x90, 60, 1 }, { 0x80, 60, 0 } }, 2 },
+    { "system common ends running status",
+      { 0x90, 60, 1, 0xF2, 1, 2, 61, 1, 0xC1, 5, 6, 0xB0, 1, 127 }, 14,
+      { { 0x90, 60, 1 }, { 0xC1, 5, 0 }, { 0xC1, 6, 0 }, { 0xB0, 1, 127 } }, 4 },
+    { "data with no status is dropped",
+      { 60, 100, 0x92, 60 }, 4,
+      { { 0 } }, 0 },
+    { "pitch bend and channel pressure",
+      { 0xE0, 0, 64, 0xD3, 9 }, 5,
+      { { 0xE0, 0, 64 }, { 0xD3, 9, 0 } }, 2 },
+};
+
+static void _check_stream(const stream_t *s) {
+    midi_parser_t parser;
+    midi_parser_init(&parser);
+    uint8_t got = 0;
+    for (uint8_t i = 0; i < s->num_bytes; i++) {
+        midi_msg_t msg;
+        if (!midi_parse(&parser, s->bytes[i], &msg)) {
+            continue;
+        }
+        if (got < s->num_want) {
+            const midi_msg_t *w = &s->want[got];
+            CHECK(msg.status == w->status && msg.data1 == w->data1 && msg.data2 == w->data2,
+                  "%s: message %d is %02X %02X %02X, not %02X %02X %02X", s->name, got,
+                  msg.status, msg.data1, msg.data2, w->status, w->data1, w->data2);
+        }
+        got++;
+    }
+    CHECK(got == s->num_want, "%s: %d messages, not %d", s->name, got, s->num_want);
+    printf("%s: %d messages\n", s->name, got);
+}
+
+#define NOTE_BUFFERS 8
+static int16_t x[NOTE_BUFFERS * SAMPLES_PER_BUFFER];
+
+// A4 on for one buffer, then off, on the plucked C4 (pattern 1), whose
+// envelope has no release of its own
+static void _check_note() {
+    host_play(1, MAX_POT / 2);
+    tone_note_on(69, 100);
+    host_render(x, SAMPLES_PER_BUFFER);
+    tone_note_off(69);
+    host_render(x + SAMPLES_PER_BUFFER, (NOTE_BUFFERS - 1) * SAMPLES_PER_BUFFER);
+
+    // the sequencer's own C4 would have started at sample 0 too, so check
+    // it's A4 that plays
+    int crossings = 0, peak = 0;
+    for (int i = 1; i < SAMPLES_PER_BUFFER; i++) {
+        crossings += x[i - 1] < 0 && x[i] >= 0;
+        peak = MAX(peak, abs(x[i]));
+    }
+    // no faster than the sine itself changes at its peak
+    double sine_step = 2 * M_PI * 440 / SAMPLE_RATE * peak;
+    int max_step = 0, last = 0;
+    for (int i = 1; i < NOTE_BUFFERS * SAMPLES_PER_BUFFER; i++) {
+        max_step = MAX(max_step, abs(x[i] - x[i - 1]));
+        if (x[i]) {
+            last = i;
+        }
+    }
+    printf("note off: largest step %d, silent %d samples after\n",
+           max_step, last + 1 - SAMPLES_PER_BUFFER);
+    CHECK(crossings == 7, "%d cycles in the first buffer, not 7 of 440Hz", crossings);
+    CHECK(max_step < sine_step * 1.01, "a %d step: the note off clicks", max_step);
+    CHECK(last + 1 - SAMPLES_PER_BUFFER >= MS(30) * 3 / 4, "released in %d samples",
+          last + 1 - SAMPLES_PER_BUFFER);
+    CHECK(last < NOTE_BUFFERS * SAMPLES_PER_BUFFER - 1, "still playing");
+}
+
+int main() {
+    for (uint i = 0; i < sizeof(streams) / sizeof(streams[0]); i++) {
+        _check_stream(&streams[i]);
+    }
+    _check_note();
+    return host_failures ? 1 : 0;
+}
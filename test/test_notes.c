@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Tuning of the chromatic note table against equal temperament from
+// NOTE_A4_HZ: the phase increments themselves, then each note as actually
+// played, picked with the pot (PATTERN_POT_NOTE).
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "tables.h"
+#include "tone_patterns.h"
+
+#define MAX_TABLE_CENTS 0.0001 // rounding the phase increment
+#define MAX_PLAYED_CENTS 0.001 // what zero crossings can resolve in 2s
+#define N (125 * SAMPLES_PER_BUFFER) // 2s
+
+static int16_t x[N];
+
+static double _cents(double freq, double ideal) {
+    return 1200 * log2(freq / ideal);
+}
+
+// The slope of a least squares line through every rising zero crossing
+// (interpolated) against its cycle number, so it holds up near Nyquist too
+static double _measure_freq(const int16_t *x, size_t n) {
+    double sk = 0, st = 0, skk = 0, skt = 0;
+    int k = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (x[i - 1] < 0 && x[i] >= 0) {
+            double t = (i - 1) + (double)-x[i - 1] / (x[i] - x[i - 1]);
+            sk += k; st += t; skk += (double)k * k; skt += k * t;
+            k++;
+        }
+    }
+    double period = (k * skt - sk * st) / (k * skk - sk * sk);
+    return SAMPLE_RATE / period;
+}
+
+int main() {
+    uint8_t pot_note_tone = 0;
+    for (uint8_t t = 0; t < num_tone_patterns; t++) {
+        if (tone_patterns[t].wave == WAVE_SINE && (tone_patterns[t].flags & PATTERN_POT_NOTE)) {
+            pot_note_tone = t;
+            break;
+        }
+    }
+    CHECK(pot_note_tone, "no sine PATTERN_POT_NOTE pattern");
+
+    double worst_table = 0, worst_played = 0;
+    for (int i = 0; i < NUM_NOTES; i++) {
+        double ideal = NOTE_A4_HZ * pow(2, (NOTE_FIRST_MIDI + i - 69) / 12.0);
+        double table_cents = _cents(note_table[i] * (double)SAMPLE_RATE / 4294967296.0, ideal);
+        CHECK(fabs(table_cents) < MAX_TABLE_CENTS, "note %d: table %+.6f cents", i, table_cents);
+        worst_table = MAX(worst_table, fabs(table_cents));
+
+        // the middle of the note's stretch of the pot
+        uint16_t pot = ((2 * i + 1) * (MAX_POT + 1)) / (2 * NUM_NOTES);
+        host_play(pot_note_tone, pot);
+        host_render(x, N);
+        double played_cents = _cents(_measure_freq(x, N), ideal);
+        CHECK(fabs(played_cents) < MAX_PLAYED_CENTS, "note %d: played %+.4f cents", i, played_cents);
+        worst_played = MAX(worst_played, fabs(played_cents));
+    }
+    printf("%d notes, A4 = %gHz: table within %.6f cents, played within %.4f cents\n",
+           NUM_NOTES, (double)NOTE_A4_HZ, worst_table, worst_played);
+    return host_failures ? 1 : 0;
+}
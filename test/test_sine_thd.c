@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// THD of the steady sine tones (C4, G4, C5, C6), against the truncated
+// 2048 entry float table they were played from before the quarter-wave
+// table.
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "tone_patterns.h"
+
+#define N 65536
+
+// What the tones measure now, dB below the fundamental
+#define MAX_THD_DB -100
+#define MAX_THD_N_DB -85
+#define MIN_IMPROVEMENT_DB 20 // THD+N
+
+static int16_t x[N];
+
+// The old play_tone(): 0.4 of a 2048 entry cosine table, read by truncating
+// a float phase
+static void _old_tone(float freq, int16_t *out, size_t n) {
+    static int16_t table[2048];
+    for (int i = 0; i < 2048; i++) {
+        table[i] = 32767 * cosf(i * 2 * (float)(M_PI / 2048));
+    }
+    float phase = 0, delta_phi = freq / SAMPLE_RATE * 2048;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (int16_t)(0.4f * table[(int)phase]);
+        phase += delta_phi;
+        if (phase >= 2048.0f) {
+            phase -= 2048.0f;
+        }
+    }
+}
+
+int main() {
+    const struct { uint8_t tone; float old_hz; } tones[] = {
+        { 0, 262 }, { 2, 392 }, { 4, 523 }, { 6, 1047 },
+    };
+    for (int t = 0; t < 4; t++) {
+        uint32_t delta = tone_patterns[tones[t].tone].notes[0];
+        double freq = delta * (double)SAMPLE_RATE / 4294967296.0;
+        host_play(tones[t].tone, 0);
+        host_render(x, N);
+        double noise, thd;
+        double rms = host_fit_sine(x, N, freq, &noise, &thd);
+        double thd_db = host_db(thd / rms), thd_n_db = host_db(noise / rms);
+
+        float old_hz = tones[t].old_hz;
+        _old_tone(old_hz, x, N);
+        double old_freq = (double)(old_hz / SAMPLE_RATE * 2048) * SAMPLE_RATE / 2048;
+        double old_noise, old_thd;
+        double old_rms = host_fit_sine(x, N, old_freq, &old_noise, &old_thd);
+        double old_thd_n_db = host_db(old_noise / old_rms);
+
+        printf("%7.2fHz: THD %6.1fdB THD+N %5.1fdB (before: THD %6.1fdB THD+N %5.1fdB)\n",
+               freq, thd_db, thd_n_db, host_db(old_thd / old_rms), old_thd_n_db);
+        CHECK(thd_db < MAX_THD_DB, "THD %.1fdB", thd_db);
+        CHECK(thd_n_db < MAX_THD_N_DB, "THD+N %.1fdB", thd_n_db);
+        CHECK(thd_n_db < old_thd_n_db - MIN_IMPROVEMENT_DB, "THD+N only %.1fdB better",
+              old_thd_n_db - thd_n_db);
+    }
+    return host_failures ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+
+// Plucked strings have to die away and say so (ks_silent()), so their
+// voices stop being rendered: at every octave, with the shortest and longest
+// decays the pot gives, and not before they've rung out.
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "karplus.h"
+#include "noise.h"
+#include "tables.h"
+#include "tone_patterns.h"
+
+#define MIN_RING 0.75 // of the 60dB decay, before it may go silent
+#define MAX_RING 2.0  // by when it must have
+
+static const uint32_t decays[] = { MS(PLUCK_TIME), MS(PLUCK_TIME + 3000) };
+
+int main() {
+    static ks_t ks;
+    static noise_t noise;
+    int16_t out[SAMPLES_PER_BUFFER];
+    ks_init(&ks, 0);
+    noise_init(&noise, 1);
+
+    for (size_t d = 0; d < sizeof(decays) / sizeof(decays[0]); d++) {
+        for (int i = 0; i < NUM_NOTES; i += 12) {
+            uint32_t decay = decays[d];
+            uint32_t limit = (uint32_t)(decay * MAX_RING);
+            ks_pluck(&ks, note_table[i], decay, KS_FULL_BRIGHTNESS, &noise);
+            uint32_t t = 0;
+            while (!ks_silent(&ks) && t < limit) {
+                ks_block(&ks, out, SAMPLES_PER_BUFFER);
+                t += SAMPLES_PER_BUFFER;
+            }
+            double ring = (double)t / decay;
+            printf("MIDI %d, 60dB in %u: silent after %u samples (%.2f of the decay)\n",
+                   NOTE_FIRST_MIDI + i, decay, t, ring);
+            CHECK(ks_silent(&ks), "MIDI %d, 60dB in %u: still sounding after %u samples",
+                  NOTE_FIRST_MIDI + i, decay, t);
+            CHECK(ring >= MIN_RING, "MIDI %d, 60dB in %u: silent after only %u samples",
+                  NOTE_FIRST_MIDI + i, decay, t);
+        }
+    }
+    return host_failures ? 1 : 0;
+}
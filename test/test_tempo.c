@@ -0,0 +1,134 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+
+// The tempo clock over an hour of BEAT patterns: beat k has to start on
+// sample floor(k * SAMPLE_RATE * 60 / bpm), with no drift, at tempos whose
+// beats aren't a whole number of samples. Also that the pot near 0 at
+// power on, so set_tone_speed() isn't called, still gives a tempo.
+
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "host.h"
+#include "tone_patterns.h"
+
+#define HOUR_BUFFERS (3600 * SAMPLE_RATE / SAMPLES_PER_BUFFER)
+#define MIN_GAP 100    // zeros before a sample, for it to be an onset
+#define MAX_OFFSET 2   // samples from the beat to the first nonzero one
+
+typedef struct {
+    uint16_t pot; // or BOOT
+    uint16_t bpm;
+} tempo_t;
+
+#define BOOT UINT16_MAX
+
+static const tempo_t tempos[] = {
+    { BOOT,    TEMPO_MIN_BPM },
+    { 614,     70 },  // 13714.29 samples a beat
+    { 1535,    115 }, // 8347.83
+    { MAX_POT, TEMPO_MAX_BPM },
+};
+
+static int16_t buf[SAMPLES_PER_BUFFER];
+
+// render_mark() prints every beat, which would bury the results
+static void _quiet(bool on) {
+    static int saved = -1;
+    fflush(stdout);
+    if (on) {
+        saved = dup(STDOUT_FILENO);
+        freopen("/dev/null", "w", stdout);
+    } else {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+}
+
+// Renders an hour and checks every onset against its beat. The first
+// beat sets the offset (the sine starts at 0, so maybe a sample late)
+// that every other beat has to keep.
+static void _check_hour(uint8_t tone, const tempo_t *t) {
+    if (t->pot == BOOT) {
+        host_boot(tone);
+    } else {
+        host_play(tone, t->pot);
+    }
+    uint64_t sample = 0;
+    uint32_t zeros = MIN_GAP, beats = 0, bad = 0;
+    int64_t offset = 0, first_bad = 0;
+    uint64_t first_bad_beat = 0;
+
+    _quiet(true);
+    for (uint32_t b = 0; b < HOUR_BUFFERS; b++) {
+        host_render(buf, SAMPLES_PER_BUFFER);
+        for (uint i = 0; i < SAMPLES_PER_BUFFER; i++, sample++) {
+            if (buf[i] == 0) {
+                zeros++;
+                continue;
+            }
+            if (zeros >= MIN_GAP) {
+                uint64_t beat = (uint64_t)beats * SAMPLE_RATE * 60 / t->bpm;
+                int64_t late = (int64_t)(sample - beat);
+                if (beats == 0) {
+                    offset = late;
+                } else if (late != offset && bad++ == 0) {
+                    first_bad_beat = beats;
+                    first_bad = late;
+                }
+                beats++;
+            }
+            zeros = 0;
+        }
+    }
+    _quiet(false);
+
+    const char *pot = t->pot == BOOT ? " at boot" : "";
+    printf("tone %d, %d bpm%s: %u beats in an hour, first %lld samples late\n",
+           tone, t->bpm, pot, beats, (long long)offset);
+    CHECK(beats == (uint32_t)t->bpm * 60, "tone %d, %d bpm: %u beats, not %u",
+          tone, t->bpm, beats, t->bpm * 60);
+    CHECK(offset >= 0 && offset <= MAX_OFFSET, "tone %d, %d bpm: first beat %lld samples late",
+          tone, t->bpm, (long long)offset);
+    CHECK(bad == 0, "tone %d, %d bpm: %u beats off, first beat %llu by %lld samples",
+          tone, t->bpm, bad, (unsigned long long)first_bad_beat, (long long)(first_bad - offset));
+}
+
+int main() {
+    bool booted = false;
+    for (uint8_t tone = 0; tone < num_tone_patterns; tone++) {
+        if (tone_patterns[tone].step != BEAT) {
+            continue;
+        }
+        for (size_t i = 0; i < sizeof(tempos) / sizeof(tempos[0]); i++) {
+            // booting only works once, before anything else plays
+            if (tempos[i].pot == BOOT && booted) {
+                continue;
+            }
+            booted = true;
+            _check_hour(tone, &tempos[i]);
+        }
+    }
+    CHECK(booted, "no BEAT patterns");
+    return host_failures ? 1 : 0;
+}
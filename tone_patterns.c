@@ -0,0 +1,181 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "pico/stdlib.h"
+
+#include "tables.h" // generated, NOTE_* see gen_tables.pl
+#include "tone_patterns.h"
+
+// A quick ramp up, ring for PLUCK_TIME, then die away as set by the pot.
+static const env_shape_t pluck = {
+    .attack = MS(2.5),
+    .hold = MS(PLUCK_TIME - 2.5),
+    .decay = POT_TIME,
+};
+
+// Two-tone intermodulation tests. SMPTE is 60Hz and 7kHz at 4:1. CCIF is
+// 19kHz and 20kHz at 1:1 with a 48kHz clock; under our 8kHz Nyquist that
+// becomes 6kHz and 7kHz, keeping the 1kHz difference tone.
+static const uint16_t smpte_mix[] = { MIX_GAIN(4, 5), MIX_GAIN(1, 5) };
+static const uint16_t ccif_mix[] = { MIX_GAIN(1, 2), MIX_GAIN(1, 2) };
+
+// Bursts of 1kHz for gates and compressors, half a second apart. Levels are
+// 0dB (32768), and -20dB (3277) then 0dB to see the attack and release.
+static const burst_t gate_burst = { 500, 1, { 32768 } };
+static const burst_t comp_burst = { 500, 2, { 3277, 32768 } };
+
+// -40dBFS up to 0dBFS in 1dB steps
+static const staircase_t stairs_40 = { 40, 0, 1 };
+
+// reference levels, see REF_TONE()
+static const staircase_t ref_0 = { 0, 0, 0 };
+static const staircase_t ref_10 = { 10, 10, 0 };
+static const staircase_t ref_20 = { 20, 20, 0 };
+
+// Metronome clicks and tone pulses for BEAT patterns, so the sound starts
+// on the beat's sample. Short enough for 240bpm.
+static const env_shape_t click = {
+    .attack = MS(0.5),
+    .hold = MS(2),
+    .decay = MS(10),
+};
+static const env_shape_t beat_pulse = {
+    .attack = MS(1),
+    .sustain = 32768,
+    .release = MS(2),
+    .gate = MS(50),
+};
+
+// A steady sine at a calibrated level
+#define REF_TONE(f, ref) { .wave = WAVE_SINE, .repeat = 1, .num_notes = 1, .notes = { HZ(f) }, \
+                           .stairs = &ref }
+
+// NOTE: settings saved in flash refer to these by index, so add new
+// patterns at the end.
+const tone_pattern_t tone_patterns[] = {
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C4 } },
+    { .wave = WAVE_SINE, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_C4 } },
+
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_G4 } },
+    { .wave = WAVE_SINE, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_G4 } },
+
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C5 } },
+    { .wave = WAVE_SINE, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_C5 } },
+
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C6 } },
+    { .wave = WAVE_SINE, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_C6 } },
+
+    // plucked C major arpeggio, each note twice
+    { .wave = WAVE_SINE, .env = &pluck, .step = POT_TIME, .repeat = 2, .num_notes = 4,
+      .notes = { NOTE_C4, NOTE_E4, NOTE_G4, NOTE_C5 } },
+
+    // harmonically rich tones for slew-rate and clipping checks
+    { .wave = WAVE_SQUARE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C4 } },
+    { .wave = WAVE_SAW, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C4 } },
+    { .wave = WAVE_TRIANGLE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C4 } },
+    { .wave = WAVE_SQUARE, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_C6 } },
+    { .wave = WAVE_SAW, .env = &pluck, .step = POT_TIME, .repeat = 2, .num_notes = 4,
+      .notes = { NOTE_E2, NOTE_A2, NOTE_D3, NOTE_G3 } },
+
+    // log sine sweeps up to Nyquist for frequency response. The last note is
+    // only where the sweep ends. Each start is logged, see render_mark().
+    { .wave = WAVE_SINE, .step = MS(10000), .repeat = 1, .num_notes = 2,
+      .notes = { HZ(20), HZ(8000) }, .flags = PATTERN_SWEEP },
+    { .wave = WAVE_SINE, .step = MS(2000), .repeat = 1, .num_notes = 2,
+      .notes = { HZ(20), HZ(8000) }, .flags = PATTERN_SWEEP },
+
+    // broadband, for tone stacks
+    { .wave = WAVE_WHITE, .step = POT_TIME, .repeat = 1, .num_notes = 1 },
+    { .wave = WAVE_PINK, .step = POT_TIME, .repeat = 1, .num_notes = 1 },
+
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 2,
+      .notes = { HZ(60), HZ(7000) }, .mix = smpte_mix },
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 2,
+      .notes = { HZ(6000), HZ(7000) }, .mix = ccif_mix },
+
+    // plucked strings: low E, A, and the open strings one after another
+    { .wave = WAVE_STRING, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_E2 } },
+    { .wave = WAVE_STRING, .step = POT_TIME, .repeat = 1, .num_notes = 1, .notes = { NOTE_A2 } },
+    { .wave = WAVE_STRING, .step = POT_TIME, .repeat = 1, .num_notes = 6,
+      .notes = { NOTE_E2, NOTE_A2, NOTE_D3, NOTE_G3, NOTE_B3, NOTE_E4 } },
+
+    // Chords, for fuzz and octave pedals. Open E major strummed on strings,
+    // first quickly and then slowly, and a plucked sawtooth E5 power chord
+    // all at once.
+    { .wave = WAVE_STRING, .step = POT_TIME, .repeat = 1, .num_notes = 6,
+      .notes = { NOTE_E2, NOTE_B2, NOTE_E3, NOTE_GS3, NOTE_B3, NOTE_E4 },
+      .flags = PATTERN_CHORD, .strum = MS(12) },
+    { .wave = WAVE_STRING, .step = POT_TIME, .repeat = 1, .num_notes = 6,
+      .notes = { NOTE_E2, NOTE_B2, NOTE_E3, NOTE_GS3, NOTE_B3, NOTE_E4 },
+      .flags = PATTERN_CHORD, .strum = MS(40) },
+    { .wave = WAVE_SAW, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 3,
+      .notes = { NOTE_E2, NOTE_B2, NOTE_E3 }, .flags = PATTERN_CHORD, .strum = 0 },
+
+    { .wave = WAVE_SINE, .repeat = 1, .num_notes = 1, .notes = { HZ(1000) }, .burst = &gate_burst },
+    { .wave = WAVE_SINE, .repeat = 1, .num_notes = 1, .notes = { HZ(1000) }, .burst = &comp_burst },
+
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { HZ(1000) }, .stairs = &stairs_40 },
+    { .wave = WAVE_SINE, .step = POT_TIME, .repeat = 1, .num_notes = 1,
+      .notes = { HZ(100) }, .stairs = &stairs_40 },
+
+    // MLS of order 12 (0.26s) to 16 (4.1s). Each period start is logged.
+    { .wave = WAVE_MLS, .repeat = 1, .num_notes = 1, .notes = { 12 } },
+    { .wave = WAVE_MLS, .repeat = 1, .num_notes = 1, .notes = { 14 } },
+    { .wave = WAVE_MLS, .repeat = 1, .num_notes = 1, .notes = { 16 } },
+
+    // reference tones: 1kHz at 0, -10 and -20dBFS, 100Hz at -20dBFS
+    REF_TONE(1000, ref_0),
+    REF_TONE(1000, ref_10),
+    REF_TONE(1000, ref_20),
+    REF_TONE(100, ref_20),
+
+    // variable oscillators, for sweeping wahs and filters by hand
+    { .wave = WAVE_SINE, .step = FOREVER, .repeat = 1, .num_notes = 1, .flags = PATTERN_POT_FREQ },
+    { .wave = WAVE_SAW, .step = FOREVER, .repeat = 1, .num_notes = 1, .flags = PATTERN_POT_FREQ },
+
+    // chromatic reference notes, E1 to B8, picked with the pot
+    { .wave = WAVE_SINE, .step = FOREVER, .repeat = 1, .num_notes = 1, .flags = PATTERN_POT_NOTE },
+    { .wave = WAVE_SAW, .step = FOREVER, .repeat = 1, .num_notes = 1, .flags = PATTERN_POT_NOTE },
+
+    // tempo, 40 to 240bpm on the pot: a metronome in 4/4 with the downbeat
+    // an octave up, and 50ms 1kHz pulses for timing tap tempo delays. Each
+    // beat is logged.
+    { .wave = WAVE_SINE, .env = &click, .step = BEAT, .repeat = 1, .num_notes = 4,
+      .notes = { HZ(2000), HZ(1000), HZ(1000), HZ(1000) } },
+    { .wave = WAVE_SINE, .env = &beat_pulse, .step = BEAT, .repeat = 1, .num_notes = 1,
+      .notes = { HZ(1000) } },
+
+    // FM for rich spectra from no extra tables. The pot turns the index
+    // up from a plain sine: all harmonics, then odd ones only. Then
+    // inharmonic bells, where the envelope sets the index so they start
+    // bright and darken as they decay.
+    { .wave = WAVE_FM, .step = FOREVER, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_A2 }, .fm_ratio = FM_RATIO(1) },
+    { .wave = WAVE_FM, .step = FOREVER, .repeat = 1, .num_notes = 1,
+      .notes = { NOTE_A2 }, .fm_ratio = FM_RATIO(2) },
+    { .wave = WAVE_FM, .env = &pluck, .step = POT_TIME, .repeat = 1, .num_notes = 4,
+      .notes = { NOTE_C4, NOTE_E4, NOTE_G4, NOTE_C5 }, .fm_ratio = FM_RATIO(3.5) },
+};
+const uint8_t num_tone_patterns = sizeof(tone_patterns) / sizeof(tone_patterns[0]);
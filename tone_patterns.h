@@ -0,0 +1,136 @@
+/*
+Copyright (C) 2024  Mark A. Stratman <mark@mas-effects.com>
+
+This file is part of tonegen-v4
+
+tonegen-v4 is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+tonegen-v4 is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with tonegen-v4; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// The table of tone patterns the "tone gen" button steps through. Adding a
+// pattern only costs an entry in tone_patterns.c.
+
+#ifndef TG_TONE_PATTERNS_H
+#define TG_TONE_PATTERNS_H
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+
+// Times are in samples. MS() converts at compile time.
+#define MS(ms) ((uint32_t)((ms) * SAMPLE_RATE_MS))
+
+// Phase increment for a frequency, worked out at compile time. See
+// oscillator.h. For musical notes use NOTE_* from tables.h, which are exact
+// and follow the A4 tuning the firmware was built with.
+#define HZ(f) ((uint32_t)((f) * 4294967296.0 / SAMPLE_RATE + 0.5))
+
+// Stands in for a time that is set by the pot. For a step it's PLUCK_TIME plus
+// the pot's speed, for any envelope time 80% of the pot's speed. See
+// set_tone_speed().
+#define POT_TIME UINT32_MAX
+
+// A step that doesn't end (74 hours), for one steady note
+#define FOREVER (UINT32_MAX - 1)
+
+// A step of one beat. The pot sets the tempo, TEMPO_MIN_BPM to
+// TEMPO_MAX_BPM, instead of the speed. Beats are counted in output samples,
+// so they stay exact however long it runs.
+#define BEAT (UINT32_MAX - 2)
+#define TEMPO_MIN_BPM 40
+#define TEMPO_MAX_BPM 240
+
+#define PLUCK_TIME 70 // each note will play at least this long (ms)
+
+#define WAVE_SINE 0
+#define WAVE_SQUARE 1   // band-limited, see osc_wavetable()
+#define WAVE_SAW 2
+#define WAVE_TRIANGLE 3
+#define WAVE_WHITE 4    // noise, the notes are ignored. See noise.h
+#define WAVE_PINK 5
+#define WAVE_STRING 6   // Karplus-Strong, see karplus.h
+#define WAVE_MLS 7      // notes[0] is the order, see noise.h. Calibrated level, no tone volume.
+#define WAVE_FM 8       // two operator FM, see osc_fm_block() and fm_ratio
+
+#define MAX_PATTERN_NOTES 8
+
+// Q15 gain for one part of a mix, e.g. MIX_GAIN(4, 5) and MIX_GAIN(1, 5) for a
+// 4:1 pair. Rounds down so the gains never add up to more than full scale.
+#define MIX_GAIN(part, total) ((uint16_t)((part) * 32768.0 / (total)))
+
+// WAVE_FM modulator frequency as a multiple of the note's, e.g. FM_RATIO(1)
+// for all the harmonics, FM_RATIO(2) for odd ones, or FM_RATIO(3.5) for
+// inharmonic bells
+#define FM_RATIO(r) ((uint16_t)((r) * 256 + 0.5))
+
+// flags
+#define PATTERN_SWEEP 0x01 // each step sweeps (log) from its note to the next, sine only
+#define PATTERN_CHORD 0x02 // each step plays all the notes, strum samples apart
+#define PATTERN_POT_FREQ 0x04 // the pot sets the frequency, 20Hz to 8kHz, not the speed. Sine or wavetables.
+#define PATTERN_POT_NOTE 0x08 // the pot picks a note from note_table, not the speed
+
+// Envelope times are in samples, and any of them can be POT_TIME.
+typedef struct {
+    uint32_t attack;
+    uint32_t hold;
+    uint32_t decay;
+    uint16_t sustain; // Q15, 0 to 32768
+    uint32_t release;
+    uint32_t gate;    // onset to release, 0 to sustain until the next note
+} env_shape_t;
+
+#define MAX_BURST_LEVELS 4
+
+// Tone bursts: the note starts on a zero crossing, plays for a whole number
+// of cycles and stops on one, then rests until the next burst. The pot sets
+// the duty, from one cycle on up to no rest at all.
+typedef struct {
+    uint16_t cycles;     // per burst, on plus off
+    uint8_t num_levels;
+    uint16_t levels[MAX_BURST_LEVELS]; // Q15, one burst at each in turn
+} burst_t;
+
+// Level staircases for transfer curves and clipping points. The first note
+// steps from `from` dB below full scale to `to`, `step` dB at a time, each
+// level held for the pattern's step. The holds are rounded up to whole
+// cycles so every level starts on a zero crossing. The levels are dBFS at
+// the output (a full scale sine is 0dBFS): these skip the usual tone volume.
+// With from == to it's a reference tone that stays at one level.
+typedef struct {
+    uint8_t from; // dB below full scale, see db_gain_table
+    uint8_t to;
+    uint8_t step;
+} staircase_t;
+
+// Patterns use designated initializers. The fields from flags on are off
+// when they're left out.
+typedef struct {
+    uint8_t wave;           // WAVE_*
+    const env_shape_t *env; // NULL plays continuously at full level
+    uint32_t step;          // samples per note, or POT_TIME
+    uint8_t repeat;         // times each note is played before moving on
+    uint8_t num_notes;
+    uint32_t notes[MAX_PATTERN_NOTES]; // see HZ()
+    uint8_t flags;          // PATTERN_*
+    const uint16_t *mix;    // if set, all notes play at once with these gains (MIX_GAIN)
+    uint32_t strum;         // PATTERN_CHORD: samples from one note's onset to the next
+    const burst_t *burst;   // if set, the first note plays in bursts. step is unused.
+    const staircase_t *stairs; // if set, the first note steps through levels
+    uint16_t fm_ratio;      // WAVE_FM: FM_RATIO(). The envelope sets the index, or the pot without one.
+} tone_pattern_t;
+
+extern const tone_pattern_t tone_patterns[];
+extern const uint8_t num_tone_patterns;
+
+#endif
@@ -20,129 +20,539 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "pico/stdlib.h"
 #include "pico/audio_i2s.h"  // pico-extras
-#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "constants.h"
 #include "debug.h"
-
-#define PLUCK_TIME 70 // each note will play at least this long (ms)
-#define NOTE_CHUNK_TIME 10 // we damp in intervals of this (ms)
+#include "envelope.h"
+#include "karplus.h"
+#include "noise.h"
+#include "oscillator.h"
+#include "render.h"
+#include "tone_patterns.h"
+
+// All note timing is counted in output samples, not wall-clock time, so
+// onsets land on exact sample indices no matter how the buffers are consumed.
 #define MAX_NOTE_TIME 3000 // how much time beyond PLUCK_TIME might it ring out (ms)
-#define RAMP_AMOUNT 0.01f
+#define PLUCK_SAMPLES (PLUCK_TIME * SAMPLE_RATE_MS)
+
+// Tones play at a fixed level to match the samples: a full scale sine peaks
+// at -8dBFS (a gain of 0.398).
+#define TONE_LEVEL_DB 8 // below full scale
+#define TONE_GAIN ((int32_t)db_gain_table[TONE_LEVEL_DB]) // Q15
+
+// Strings get brighter as the pot turns up, from this (Q15) to all of the
+// pluck's noise.
+#define STRING_DULLEST 4096
+
+// PATTERN_POT_FREQ glides to a new frequency with a time constant of
+// 2^GLIDE_SHIFT samples (32ms)
+#define GLIDE_SHIFT 9
 
-#define TONE_VOL 0.4f // to match samples
+// PATTERN_POT_NOTE splits the pot evenly between the notes. It has to go
+// this far past the edge of the current note's span to change note, so ADC
+// noise on a boundary doesn't flip between two.
+#define NOTE_HYSTERESIS 8
 
-#define NOTE_LENGTH_PERCENT_OF_SPEED 0.8f // 80% of the scaled_speed will be filled with tone
+// MLS level. It's a square wave of random length pulses, so its RMS is its
+// peak. Leaves some room for a pedal with gain.
+#define MLS_LEVEL_DB 6 // below full scale
+
+// WAVE_FM's index at full envelope or the top of the pot. Low notes only
+// keep all the sidebands this makes under Nyquist.
+#define FM_MAX_INDEX FM_INDEX(8)
+
+#define NOTE_LENGTH_PERCENT_OF_SPEED 80 // 80% of the speed will be filled with tone
 uint16_t speed; // 0-MAX_POT. Proportion of MAX_NOTE_TIME for repeating notes
 
-// cache the calculated values, (ms)
-uint16_t scaled_speed;
-uint16_t scaled_length;
-float damp_amount = 0.01; // arbitrary starting value. Really you need to call set_tone_speed() first
+// cache the calculated values (samples)
+uint32_t speed_samples;  // from the end of PLUCK_TIME to the next onset
+uint32_t length_samples; // how much of that is spent decaying
 
-#define SINE_WAVE_TABLE_LEN 2048
-static int16_t sine_wave_table[SINE_WAVE_TABLE_LEN];
+// The tempo clock for BEAT steps. A beat is SAMPLE_RATE * 60 / tempo_bpm
+// samples, which is rarely whole, so the remainder is carried into the next
+// beat: beat k always starts on sample floor(k * SAMPLE_RATE * 60 / bpm).
+uint16_t tempo_bpm = TEMPO_MIN_BPM; // never 0, _next_beat() divides by it
+uint32_t beat_frac; // samples * tempo_bpm left over from the last beat
 
-#define NUM_TONES 8 // see play_tone()
 uint8_t tone_i = 0;
 
-uint16_t freq;
-float phase = 0.0f; // phase accumulator
-float delta_phi;
+// A fixed pool of voices, one per guitar string. Patterns with an envelope,
+// and strings, are polyphonic: each note takes a free voice or steals the
+// one that started longest ago, and the old notes ring on. Anything else
+// plays continuously on voice 0.
+#define TONE_VOICES 6
+#if TONE_VOICES > KS_MAX_STRINGS
+#error "each voice needs its own string"
+#endif
+
+typedef struct {
+    osc_t osc;
+    env_t env;
+    osc_sweep_t sweep;  // PATTERN_SWEEP only
+    noise_t noise;      // WAVE_WHITE and WAVE_PINK
+    osc_t mix[MAX_PATTERN_NOTES]; // pattern->mix only, one per note
+    ks_t string;        // WAVE_STRING
+    osc_t mod;          // WAVE_FM's modulator
+    mls_t mls;          // WAVE_MLS
+    uint16_t level;     // Q15, bursts and staircases only
+    env_params_t params; // copied at the onset, so the pot only changes later notes
+    const env_params_t *env_params; // &params, or NULL to play at full level
+    uint8_t note;       // MIDI note being played, or NO_NOTE
+    bool active;
+    uint32_t started;   // onset count when the note started, for stealing
+} voice_t;
+
+voice_t voices[TONE_VOICES];
+uint32_t onsets = 0;
+
+// MIDI notes take the voices over from the sequencer until the pattern
+// changes. Voices for a pattern without an envelope are gated with
+// midi_gate, the others use midi_env, so notes start and stop without
+// clicks: a note off can come at any stage, and a pluck has no release.
+#define NO_NOTE 0xFF
+#define MIDI_RELEASE MS(30) // at least
+bool midi_mode = false;
+env_params_t midi_gate;
+env_params_t midi_env; // note_env with at least MIDI_RELEASE
+
+// The sequencer. It walks through pattern->notes, playing each one
+// pattern->repeat times, or all of them every step for PATTERN_CHORD.
+const tone_pattern_t *pattern = NULL;
+uint8_t note_i;
+uint8_t repeat_i;
+uint8_t strum_i;       // PATTERN_CHORD: the next note in the chord
+bool burst_on;         // the next onset ends a burst
+uint8_t level_i;       // the next burst's level
+uint8_t stair_db;      // the next staircase level, dB below full scale
+uint8_t pot_note;      // PATTERN_POT_NOTE: index into note_table
+uint32_t onset_left;   // samples until the next onset
+uint32_t step_len;     // samples in the current step
+env_params_t note_env; // pattern->env with the pot applied
+
+// scratch space for one buffer
+int16_t wave[SAMPLES_PER_BUFFER];  // raw oscillator output, one voice
+uint16_t gain[SAMPLES_PER_BUFFER]; // envelope, Q15
+uint16_t fm_index[SAMPLES_PER_BUFFER]; // FM_INDEX()
+int32_t voice_sum[SAMPLES_PER_BUFFER]; // all voices
+
+static inline uint32_t _pot_time(uint32_t t, uint32_t from_pot) {
+    return t == POT_TIME ? from_pot : t;
+}
 
-struct audio_buffer_pool *tp_ap;
+// PATTERN_POT_FREQ: the phase increment for the pot, exponential from
+// POT_FREQ_MIN_HZ to POT_FREQ_MAX_HZ
+static inline uint32_t _pot_delta() {
+    uint32_t i = speed >> POT_FREQ_SHIFT;
+    uint32_t frac = speed & ((1 << POT_FREQ_SHIFT) - 1);
+    uint32_t a = pot_freq_table[i];
+    return a + (((pot_freq_table[i + 1] - a) * frac) >> POT_FREQ_SHIFT);
+}
+
+void _update_env() {
+    const env_shape_t *e = pattern->env;
+    if (e == NULL) {
+        return;
+    }
+    uint32_t release = _pot_time(e->release, length_samples);
+    env_set_times(&note_env, _pot_time(e->attack, length_samples),
+                  _pot_time(e->hold, length_samples), _pot_time(e->decay, length_samples),
+                  (int32_t)e->sustain << 15, release, _pot_time(e->gate, length_samples));
+    midi_env = note_env;
+    if (release < MIDI_RELEASE) {
+        env_set_times(&midi_env, note_env.attack, note_env.hold, note_env.decay,
+                      note_env.sustain, MIDI_RELEASE, note_env.gate);
+    }
+}
 
 void set_tone_speed(uint16_t potval) {
     speed = potval;
-    scaled_speed = (uint16_t)(((float)speed/(float)MAX_POT)*MAX_NOTE_TIME);
-    scaled_length = (uint16_t)((float)NOTE_LENGTH_PERCENT_OF_SPEED*scaled_speed);
-    damp_amount = TONE_VOL/(SAMPLE_RATE_MS*scaled_length);
+    speed_samples = ((uint32_t)speed * MAX_NOTE_TIME * SAMPLE_RATE_MS) / MAX_POT;
+    length_samples = (speed_samples * NOTE_LENGTH_PERCENT_OF_SPEED) / 100;
+    uint16_t bpm = TEMPO_MIN_BPM
+        + ((uint32_t)speed * (TEMPO_MAX_BPM - TEMPO_MIN_BPM) + MAX_POT / 2) / MAX_POT;
+    if (bpm != tempo_bpm) {
+        tempo_bpm = bpm;
+        beat_frac = 0; // it was in the old tempo's units
+        if (pattern && pattern->step == BEAT) {
+            PF("tempo %d bpm\n", tempo_bpm);
+        }
+    }
+    if (pattern) {
+        _update_env();
+    }
 }
 
-void _set_freq(uint16_t f) {
-  freq = f;
-  delta_phi = (float) ((float)freq / (float)SAMPLE_RATE) * (float)SINE_WAVE_TABLE_LEN;
+#ifndef NDEBUG
+static const char *note_names[] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+};
+#endif
+
+// PATTERN_POT_NOTE: the phase increment for the note the pot is on
+uint32_t _pot_note_delta() {
+    uint32_t span = MAX_POT + 1;
+    uint32_t lo = (pot_note * span) / NUM_NOTES;
+    uint32_t hi = ((pot_note + 1) * span) / NUM_NOTES;
+    if ((uint32_t)speed + NOTE_HYSTERESIS < lo || speed >= hi + NOTE_HYSTERESIS) {
+        pot_note = (uint8_t)((speed * NUM_NOTES) / span);
+        PF("note %s%d\n", note_names[(NOTE_FIRST_MIDI + pot_note) % 12],
+           (NOTE_FIRST_MIDI + pot_note) / 12 - 1);
+    }
+    return note_table[pot_note];
 }
 
+static uint16_t _string_brightness() {
+    return STRING_DULLEST + ((uint32_t)speed * (KS_FULL_BRIGHTNESS - STRING_DULLEST)) / MAX_POT;
+}
 
-// NOTE: This blocks
-void _pluck(uint16_t f) {
-    _set_freq(f);
+// Call after setting the carrier's delta
+static void _start_fm(voice_t *v) {
+    v->mod.delta = (uint32_t)(((uint64_t)v->osc.delta * pattern->fm_ratio) >> 8);
+    v->mod.phase = 0;
+}
 
-    float vol = 0.0f;
+// A voice keeps the times it started with. New ones in the middle of a
+// stage would leave it short of its target when the stage runs out, and
+// the level would jump there.
+static void _trigger_env(voice_t *v, const env_params_t *p) {
+    v->params = *p;
+    v->env_params = &v->params;
+    env_trigger(&v->env, v->env_params);
+}
 
-    // initial pluck causes undampened tone for PLUCK_TIME
-    // Also ramp up volume to avoid clicks and pops
-    absolute_time_t pluck_stop = make_timeout_time_ms((uint32_t)PLUCK_TIME);
-    while (! time_reached(pluck_stop)) {
-        struct audio_buffer *buffer = take_audio_buffer(tp_ap, true);
-        int16_t *samples = (int16_t *)buffer->buffer->bytes;
-        for (uint i = 0; i < buffer->max_sample_count; i++) {
-            if (vol < TONE_VOL) {
-                vol += RAMP_AMOUNT;
-            }
-            samples[i] = (int16_t)(vol * sine_wave_table[(int)phase]);
-            phase += delta_phi;
-            if (phase >= (float)SINE_WAVE_TABLE_LEN) {
-                phase -= (float)SINE_WAVE_TABLE_LEN;
+// length is the step, in samples
+void _start_note(voice_t *v, uint8_t i, uint32_t length) {
+    bool was_active = v->active;
+    v->active = true;
+    v->started = onsets++;
+    v->note = NO_NOTE;
+    v->env_params = NULL;
+    if (pattern->flags & PATTERN_POT_FREQ) {
+        // jump straight there when the pattern starts, glide from then on
+        v->osc.delta = was_active ? v->osc.delta : _pot_delta();
+    } else if (pattern->flags & PATTERN_POT_NOTE) {
+        v->osc.delta = _pot_note_delta();
+    } else {
+        v->osc.delta = pattern->notes[i];
+    }
+    if (pattern->env) {
+        _trigger_env(v, &note_env);
+        v->osc.phase = 0; // start on a zero crossing
+    }
+    if (pattern->mix) {
+        for (uint8_t j = 0; j < pattern->num_notes; j++) {
+            v->mix[j].delta = pattern->notes[j];
+            if (pattern->env) {
+                v->mix[j].phase = 0;
             }
         }
-        buffer->sample_count = buffer->max_sample_count;
-        give_audio_buffer(tp_ap, buffer);
     }
-    
-    // play a dampening sound
-    //pluck_stop = make_timeout_time_ms((uint32_t)scaled_length);
-    //while (! time_reached(pluck_stop)) {
-    while (vol > 0) {
-        struct audio_buffer *buffer = take_audio_buffer(tp_ap, true);
-        int16_t *samples = (int16_t *)buffer->buffer->bytes;
-        for (uint i = 0; i < buffer->max_sample_count; i++) {
-            samples[i] = (int16_t)(vol * sine_wave_table[(int)phase]);
+    if (pattern->wave == WAVE_STRING) {
+        // rings down 60dB by the next step, so stealing it then doesn't cut
+        // off anything you'd hear
+        ks_pluck(&v->string, v->osc.delta, length, _string_brightness(), &v->noise);
+    }
+    if (pattern->wave == WAVE_MLS) {
+        mls_start(&v->mls, (uint8_t)pattern->notes[i]);
+    }
+    if (pattern->wave == WAVE_FM && (v->env_params || !was_active)) {
+        _start_fm(v);
+    }
+    if (pattern->flags & PATTERN_SWEEP) {
+        osc_sweep_start(&v->sweep, pattern->notes[i], pattern->notes[i + 1], length);
+        v->osc.phase = 0;
+    }
+}
 
-            vol -= damp_amount;
+// These are set up in dBFS at the output, so they skip TONE_GAIN
+static inline bool _calibrated() {
+    return !midi_mode && (pattern->stairs || pattern->wave == WAVE_MLS);
+}
 
-            phase += delta_phi;
-            if (phase >= (float)SINE_WAVE_TABLE_LEN) {
-                phase -= (float)SINE_WAVE_TABLE_LEN;
-            }
+static inline bool _polyphonic() {
+    return midi_mode || pattern->env || pattern->wave == WAVE_STRING;
+}
+
+voice_t *_alloc_voice() {
+    if (!_polyphonic()) {
+        return &voices[0];
+    }
+    voice_t *oldest = &voices[0];
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        voice_t *v = &voices[i];
+        if (!v->active) {
+            return v;
+        }
+        if (onsets - v->started > onsets - oldest->started) {
+            oldest = v;
         }
-        buffer->sample_count = buffer->max_sample_count;
-        give_audio_buffer(tp_ap, buffer);
+    }
+    return oldest;
+}
+
+// Samples for cycles whole cycles of the note, rounded up so the burst ends
+// on the first sample past a zero crossing.
+static uint32_t _cycle_samples(uint32_t cycles, uint32_t delta) {
+    return (uint32_t)((((uint64_t)cycles << 32) + delta - 1) / delta);
+}
+
+// Gates voice 0 on or off for a burst. Only the edges are onsets, so the
+// gating happens per block and the rest costs nothing.
+void _next_burst() {
+    const burst_t *b = pattern->burst;
+    voice_t *v = &voices[0];
+    uint32_t delta = pattern->notes[0];
+    uint32_t on_cycles = MAX(1, ((uint32_t)speed * b->cycles) / MAX_POT);
+    uint32_t on = _cycle_samples(on_cycles, delta);
+    uint32_t period = _cycle_samples(b->cycles, delta);
+
+    if (burst_on) {
+        burst_on = false;
+        v->active = false;
+        onset_left = period > on ? period - on : 1;
+        return;
+    }
+    _start_note(v, 0, period);
+    v->osc.phase = 0;
+    v->level = b->levels[level_i];
+    if (++level_i >= b->num_levels) {
+        level_i = 0;
+    }
+    burst_on = on < period;
+    onset_left = on < period ? on : period;
+}
+
+void _next_stair() {
+    const staircase_t *st = pattern->stairs;
+    voice_t *v = &voices[0];
+    uint32_t delta = pattern->notes[0];
+    uint32_t hold = _pot_time(pattern->step, PLUCK_SAMPLES + speed_samples);
+    uint32_t cycles = (uint32_t)((((uint64_t)hold * delta) + UINT32_MAX) >> 32);
+    onset_left = _cycle_samples(cycles, delta);
+    if (st->from == st->to) {
+        onset_left = UINT32_MAX; // a reference tone, one level for good
     }
 
+    _start_note(v, 0, onset_left);
+    v->osc.phase = 0;
+    v->level = db_gain_table[stair_db];
+
+    int next = stair_db;
+    if (stair_db == st->to) {
+        next = st->from;
+    } else if (st->from > st->to) {
+        next = MAX(next - st->step, st->to);
+    } else {
+        next = MIN(next + st->step, st->to);
+    }
+    stair_db = (uint8_t)next;
+}
+
+// Samples until the next beat, see tempo_bpm
+static uint32_t _next_beat() {
+    uint32_t total = SAMPLE_RATE * 60 + beat_frac;
+    uint32_t samples = total / tempo_bpm;
+    beat_frac = total - samples * tempo_bpm;
+    return samples;
+}
 
-    // play silence
-    if (scaled_speed > scaled_length) {
-        /*
-        pluck_stop = make_timeout_time_ms((uint32_t)scaled_length);
-        while (!time_reached(pluck_stop)) {
-            struct audio_buffer *buffer = take_audio_buffer(tp_ap, true);
-            int16_t *samples = (int16_t *)buffer->buffer->bytes;
-            for (uint i = 0; i < buffer->max_sample_count; i++) {
-                samples[i] = 0;
+static uint32_t _step_samples() {
+    if (pattern->wave == WAVE_MLS) {
+        // start over from the seed each period
+        return mls_period((uint8_t)pattern->notes[0]);
+    }
+    if (pattern->step == BEAT) {
+        return _next_beat();
+    }
+    return _pot_time(pattern->step, PLUCK_SAMPLES + speed_samples);
+}
+
+// Starts the next note and sets onset_left to the time until the one after.
+void _next_onset() {
+    if (pattern->burst) {
+        _next_burst();
+        return;
+    }
+    if (pattern->stairs) {
+        _next_stair();
+        return;
+    }
+
+    // a chord's strum is all one step
+    if (!(pattern->flags & PATTERN_CHORD) || strum_i == 0) {
+        step_len = _step_samples();
+    }
+    uint32_t step = step_len;
+
+    if (pattern->flags & PATTERN_CHORD) {
+        _start_note(_alloc_voice(), strum_i, step);
+        if (++strum_i < pattern->num_notes) {
+            onset_left = pattern->strum;
+        } else {
+            // the strum comes out of the step, so the chords stay in time
+            strum_i = 0;
+            uint32_t strum = (pattern->num_notes - 1) * pattern->strum;
+            onset_left = step > strum ? step - strum : 1;
+        }
+        return;
+    }
+
+    _start_note(_alloc_voice(), note_i, step);
+    onset_left = step;
+
+    // a sweep's last note is only where it ends, and a mix plays them all
+    // in one step
+    uint8_t num_steps = pattern->num_notes - ((pattern->flags & PATTERN_SWEEP) ? 1 : 0);
+    if (pattern->mix) {
+        num_steps = 1;
+    }
+    if (++repeat_i >= pattern->repeat) {
+        repeat_i = 0;
+        if (++note_i >= num_steps) {
+            note_i = 0;
+        }
+    }
+}
+
+void restart_tone() {
+    pattern = &tone_patterns[tone_i];
+    midi_mode = false;
+    note_i = 0;
+    repeat_i = 0;
+    strum_i = 0;
+    burst_on = false;
+    level_i = 0;
+    beat_frac = 0;
+    stair_db = pattern->stairs ? pattern->stairs->from : 0;
+    pot_note = (uint8_t)(((uint32_t)speed * NUM_NOTES) / (MAX_POT + 1));
+    onset_left = 0; // the first note starts with the next buffer
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        voices[i].active = false;
+    }
+    _update_env();
+}
+
+// The pattern's plain waveform into wave[]
+void _render_wave(voice_t *v, uint n) {
+    switch (pattern->wave) {
+        case WAVE_SINE:
+            osc_sine_block(&v->osc, wave, n);
+            break;
+        case WAVE_SQUARE:
+            osc_table_block(&v->osc, osc_wavetable(WAVETABLE_SQUARE, v->osc.delta), wave, n);
+            break;
+        case WAVE_SAW:
+            osc_table_block(&v->osc, osc_wavetable(WAVETABLE_SAW, v->osc.delta), wave, n);
+            break;
+        case WAVE_TRIANGLE:
+            osc_table_block(&v->osc, osc_wavetable(WAVETABLE_TRIANGLE, v->osc.delta), wave, n);
+            break;
+        case WAVE_WHITE:
+            noise_white_block(&v->noise, wave, n);
+            break;
+        case WAVE_PINK:
+            noise_pink_block(&v->noise, wave, n);
+            break;
+        case WAVE_STRING:
+            ks_block(&v->string, wave, n);
+            break;
+        case WAVE_MLS:
+            mls_block(&v->mls, db_gain_table[MLS_LEVEL_DB], wave, n);
+            break;
+        case WAVE_FM:
+            if (pattern->env) {
+                // the envelope is already in gain[], see _render_voice()
+                for (uint i = 0; i < n; i++) {
+                    fm_index[i] = ((uint32_t)FM_MAX_INDEX * gain[i]) >> 15;
+                }
+            } else {
+                uint16_t index = ((uint32_t)FM_MAX_INDEX * speed) / MAX_POT;
+                for (uint i = 0; i < n; i++) {
+                    fm_index[i] = index;
+                }
             }
-            buffer->sample_count = buffer->max_sample_count;
-            give_audio_buffer(tp_ap, buffer);
+            osc_fm_block(&v->osc, &v->mod, fm_index, wave, n);
+            break;
+    }
+}
+
+// Adds one voice into voice_sum
+void _render_voice(voice_t *v, uint n) {
+    if (!midi_mode && (pattern->flags & PATTERN_POT_NOTE)) {
+        v->osc.delta = _pot_note_delta(); // the phase carries on, no click
+    }
+    if (v->env_params) {
+        env_render(&v->env, v->env_params, gain, n);
+    }
+
+    if (midi_mode) {
+        _render_wave(v, n); // MIDI plays plain notes
+    } else if (pattern->flags & PATTERN_POT_FREQ) {
+        uint32_t target = _pot_delta();
+        const int16_t *table = NULL;
+        // pick the band for the higher end of the glide so it can't alias
+        uint32_t top = MAX(target, v->osc.delta);
+        if (pattern->wave == WAVE_SQUARE) {
+            table = osc_wavetable(WAVETABLE_SQUARE, top);
+        } else if (pattern->wave == WAVE_SAW) {
+            table = osc_wavetable(WAVETABLE_SAW, top);
+        } else if (pattern->wave == WAVE_TRIANGLE) {
+            table = osc_wavetable(WAVETABLE_TRIANGLE, top);
         }
-        */
-       busy_wait_ms(scaled_speed - scaled_length);
+        osc_glide_block(&v->osc, table, target, GLIDE_SHIFT, wave, n);
+    } else if (pattern->mix) {
+        osc_sine_mix_block(v->mix, pattern->mix, pattern->num_notes, wave, n);
+    } else if (pattern->flags & PATTERN_SWEEP) {
+        osc_sweep_block(&v->osc, &v->sweep, wave, n);
+    } else {
+        _render_wave(v, n);
     }
 
+    if (v->env_params) {
+        for (uint i = 0; i < n; i++) {
+            voice_sum[i] += (wave[i] * gain[i]) >> 15;
+        }
+        if (env_silent(&v->env)) {
+            v->active = false;
+        }
+    } else if (!midi_mode && (pattern->burst || pattern->stairs)) {
+        // rounded, so calibrated levels come out right on average
+        for (uint i = 0; i < n; i++) {
+            voice_sum[i] += (wave[i] * v->level + (1 << 14)) >> 15;
+        }
+    } else {
+        for (uint i = 0; i < n; i++) {
+            voice_sum[i] += wave[i];
+        }
+    }
+    if (pattern->wave == WAVE_STRING && ks_silent(&v->string)) {
+        v->active = false; // like env_silent(), it has died away
+    }
 }
-void _queue_freq(uint16_t f) {
-    _set_freq(f);
-    struct audio_buffer *buffer = take_audio_buffer(tp_ap, true);
-    int16_t *samples = (int16_t *)buffer->buffer->bytes;
-    for (uint i = 0; i < buffer->max_sample_count; i++) {
-        samples[i] = (int16_t)(TONE_VOL * sine_wave_table[(int)phase]);
-        phase += delta_phi;
-        if (phase >= (float)SINE_WAVE_TABLE_LEN) {
-            phase -= (float)SINE_WAVE_TABLE_LEN;
+
+// Sums the active voices, then scales them onto the mix bus in one pass.
+// Chords can go over full scale here; the mixer saturates them (see
+// render_pull()).
+void _render_voices(int32_t *mix, uint n) {
+    memset(voice_sum, 0, n * sizeof(voice_sum[0]));
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        if (voices[i].active) {
+            _render_voice(&voices[i], n);
+        }
+    }
+    if (_calibrated()) {
+        for (uint i = 0; i < n; i++) {
+            mix[i] += voice_sum[i];
         }
+        return;
+    }
+    for (uint i = 0; i < n; i++) {
+        // six full scale voices times the gain would overflow, hence the
+        // pre-shift
+        mix[i] += ((voice_sum[i] >> 1) * TONE_GAIN) >> 14;
     }
-    buffer->sample_count = buffer->max_sample_count;
-    give_audio_buffer(tp_ap, buffer);
 }
 
 
@@ -150,13 +560,13 @@ void _queue_freq(uint16_t f) {
 
 void next_tone() {
     tone_i++;
-    if (tone_i >= NUM_TONES) {
+    if (tone_i >= num_tone_patterns) {
         tone_i = 0;
     }
     PF("tone_i=%d\n", tone_i);
 }
 void set_tone_num(uint8_t i) {
-    tone_i = i;
+    tone_i = i < num_tone_patterns ? i : 0;
 }
 uint8_t get_tone_num() {
     return tone_i;
@@ -165,37 +575,107 @@ uint8_t get_tone_num() {
 
 
 
-void tone_init() {
-    for (int i = 0; i < SINE_WAVE_TABLE_LEN; i++) {
-        sine_wave_table[i] = 32767 * cosf(i * 2 * (float)(M_PI / SINE_WAVE_TABLE_LEN));
+// Starts the pattern over if the button (or a MIDI program change) picked
+// another one
+static void _check_pattern() {
+    if (pattern != &tone_patterns[tone_i]) {
+        restart_tone();
     }
-    _set_freq(440);
 }
 
-// entry point, main function. Can block for one "plucked" note.
-void play_tone(struct audio_buffer_pool *ap) {
-    tp_ap = ap;
-    // continuous tones
-    if (tone_i == 0) {
-        _queue_freq(262);
-    } else if (tone_i == 1) {
-        _pluck(262);
+void tone_note_on(uint8_t note, uint8_t velocity) {
+    if (note < NOTE_FIRST_MIDI || note >= NOTE_FIRST_MIDI + NUM_NOTES) {
+        return;
+    }
+    _check_pattern();
+    if (!midi_mode) {
+        midi_mode = true; // the sequencer stops here
+        for (uint8_t i = 0; i < TONE_VOICES; i++) {
+            voices[i].active = false;
+        }
+    }
 
-    } else if (tone_i == 2) {
-        _queue_freq(392);
-    } else if (tone_i == 3) {
-        _pluck(392);
+    voice_t *v = _alloc_voice();
+    v->active = true;
+    v->started = onsets++;
+    v->note = note;
+    v->osc.delta = note_table[note - NOTE_FIRST_MIDI];
+    v->osc.phase = 0;
+    _trigger_env(v, pattern->env ? &midi_env : &midi_gate);
+    if (pattern->wave == WAVE_STRING) {
+        ks_pluck(&v->string, v->osc.delta, PLUCK_SAMPLES + speed_samples,
+                 _string_brightness(), &v->noise);
+    }
+    if (pattern->wave == WAVE_MLS) {
+        mls_start(&v->mls, (uint8_t)pattern->notes[0]);
+    }
+    if (pattern->wave == WAVE_FM) {
+        _start_fm(v);
+    }
+}
 
-    } else if (tone_i == 4) {
-        _queue_freq(523);
-    } else if (tone_i == 5) {
-        _pluck(523);
+void tone_note_off(uint8_t note) {
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        voice_t *v = &voices[i];
+        if (v->active && v->note == note) {
+            env_release(&v->env, v->env_params);
+            v->note = NO_NOTE;
+        }
+    }
+}
+
+void tone_all_notes_off() {
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        voice_t *v = &voices[i];
+        if (v->active && v->note != NO_NOTE) {
+            env_release(&v->env, v->env_params);
+            v->note = NO_NOTE;
+        }
+    }
+}
 
-    } else if (tone_i == 6) {
-        _queue_freq(1047);
-    } else if (tone_i == 7) {
-        _pluck(1047);
+void tone_init() {
+    osc_init();
+    env_set_times(&midi_gate, MS(2), 0, 0, ENV_ONE, MIDI_RELEASE, 0);
+    for (uint8_t i = 0; i < TONE_VOICES; i++) {
+        noise_init(&voices[i].noise, 0x2545F491 + i);
+        ks_init(&voices[i].string, i);
     }
+    // the pot at 0, like main.c's last_pot_val, which may never change
+    set_tone_speed(0);
+    restart_tone();
 }
 
+// entry point, a render_fn_t for the render graph. Renders one buffer of
+// the current pattern.
+void render_tone(void *ctx, int32_t *mix, uint n) {
+    _check_pattern();
+    if (midi_mode) {
+        _render_voices(mix, n);
+        return;
+    }
 
+    uint i = 0;
+    while (i < n) {
+        while (onset_left == 0) {
+            if (pattern->flags & PATTERN_SWEEP) {
+                render_mark("sweep", i);
+            } else if (pattern->burst && !burst_on) {
+                render_mark("burst", i);
+            } else if (pattern->wave == WAVE_MLS) {
+                render_mark("mls", i);
+            } else if (pattern->step == BEAT && strum_i == 0) {
+                render_mark("beat", i);
+            } else if (pattern->stairs) {
+                char what[16];
+                snprintf(what, sizeof(what), "%ddBFS", -(int)stair_db);
+                render_mark(what, i);
+            }
+            _next_onset();
+        }
+        uint end = i + MIN(n - i, onset_left);
+        onset_left -= end - i;
+        _render_voices(mix + i, end - i);
+        i = end;
+    }
+}
@@ -19,7 +19,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 */
 
 void tone_init();
-void play_tone(struct audio_buffer_pool *ap);
+// render_fn_t for the render graph (see render.h)
+void render_tone(void *ctx, int32_t *mix, uint n);
+// Start the current pattern over, e.g. after the audio was flushed.
+void restart_tone();
 
 void set_tone_speed(uint16_t potval); // 0 to MAX_POT
 
@@ -27,4 +30,12 @@ void set_tone_speed(uint16_t potval); // 0 to MAX_POT
 // It changes each time you press the "tone gen" button.
 void next_tone();
 void set_tone_num(uint8_t i);
-uint8_t get_tone_num();
\ No newline at end of file
+uint8_t get_tone_num();
+
+// MIDI notes (note numbers, see midi.h). The first note on stops the
+// pattern's sequence and plays notes on the tone voices instead, with the
+// pattern's waveform and envelope, until the pattern changes. Velocity is
+// ignored so levels stay the same as the patterns'. Call between buffers.
+void tone_note_on(uint8_t note, uint8_t velocity);
+void tone_note_off(uint8_t note);
+void tone_all_notes_off();